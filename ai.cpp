@@ -0,0 +1,505 @@
+#include "./ai.h"
+#include "./heuristic.h"
+#include "./thread_pool.h"
+#include "./ttable.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// How many nodes are visited between two looks at the clock.
+const uint64_t DEADLINE_CHECK_INTERVAL = 256;
+
+struct SearchContext {
+    const SearchConfig* config;
+    Clock::time_point deadline;
+    bool has_deadline;
+    bool aborted;
+    uint64_t nodes;
+    uint64_t next_check;
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+    // Shared by every task of a parallel search, so one task running
+    // out of time stops the others.
+    atomic<bool>* stop;
+    // The control's cancel flag, NULL without a control.
+    const atomic<bool>* cancel;
+};
+
+void init_search_config(SearchConfig* config) {
+    config->max_depth       = 3;
+    config->budget_us       = 0;
+    config->min_probability = 0.0001f;
+    config->eval            = { &evaluate_heuristic, NULL };
+    config->add_rewards     = false;
+    config->pool            = NULL;
+    config->split_plies     = 1;
+    config->tt              = NULL;
+    config->iterative       = false;
+    config->control         = NULL;
+}
+
+void init_search_control(SearchControl* control) {
+    control->cancel.store(false, memory_order_relaxed);
+    control->best.store(DIR_COUNT, memory_order_relaxed);
+    control->value.store(0.0f, memory_order_relaxed);
+    control->depth.store(0, memory_order_relaxed);
+}
+
+void search_control_cancel(SearchControl* control) {
+    control->cancel.store(true, memory_order_relaxed);
+}
+
+/*
+ * Publishes a finished depth. depth is stored last with release
+ * ordering, so a reader that acquires it sees the matching move.
+ */
+static void publish(SearchControl* control,
+                    Direction best,
+                    float value,
+                    int depth) {
+    if (!control) return;
+
+    control->best.store(best, memory_order_relaxed);
+    control->value.store(value, memory_order_relaxed);
+    control->depth.store(depth, memory_order_release);
+}
+
+// clang-format off
+static const float snake_weights[16] = {
+    32768.0f, 16384.0f, 8192.0f, 4096.0f,
+      256.0f,   512.0f, 1024.0f, 2048.0f,
+      128.0f,    64.0f,   32.0f,   16.0f,
+        1.0f,     2.0f,    4.0f,    8.0f,
+};
+// clang-format on
+
+float evaluate_simple(Board board, const void*) {
+    float value = 0.0f;
+    int empty   = 0;
+
+    for (int i = 0; i < 16; i++) {
+        int tile = (int)((board >> (4 * i)) & 0xF);
+
+        if (tile == 0) {
+            empty++;
+            continue;
+        }
+        value += snake_weights[i] * (float)(1 << tile) / 32768.0f;
+    }
+
+    return value + 16.0f * (float)empty;
+}
+
+static bool out_of_time(SearchContext* ctx) {
+    if (ctx->aborted) return true;
+
+    if ((ctx->has_deadline || ctx->cancel) &&
+        ctx->nodes >= ctx->next_check) {
+        ctx->next_check = ctx->nodes + DEADLINE_CHECK_INTERVAL;
+
+        if (ctx->stop->load(memory_order_relaxed) ||
+            (ctx->cancel && ctx->cancel->load(memory_order_relaxed)) ||
+            (ctx->has_deadline && Clock::now() >= ctx->deadline)) {
+            ctx->aborted = true;
+            ctx->stop->store(true, memory_order_relaxed);
+        }
+    }
+
+    return ctx->aborted;
+}
+
+static bool cache_lookup(SearchContext* ctx,
+                         Board board,
+                         int depth,
+                         float* value) {
+    if (!ctx->config->tt) return false;
+
+    ctx->tt_probes++;
+    if (!tt_probe(ctx->config->tt, board, depth, value)) return false;
+
+    ctx->tt_hits++;
+    return true;
+}
+
+static void cache_store(SearchContext* ctx,
+                        Board board,
+                        int depth,
+                        float value) {
+    // An aborted subtree's value is garbage, never cache it.
+    if (ctx->config->tt && !ctx->aborted) {
+        tt_store(ctx->config->tt, board, depth, value);
+    }
+}
+
+static float chance_node(SearchContext* ctx,
+                         Board board,
+                         int depth,
+                         float prob);
+
+/*
+ * What a move's merges add to the value of its afterstate.
+ */
+static float move_reward(const SearchConfig* config, uint32_t gain) {
+    return config->add_rewards ? (float)gain : 0.0f;
+}
+
+static float max_node(SearchContext* ctx,
+                      Board board,
+                      int depth,
+                      float prob) {
+    ctx->nodes++;
+    if (out_of_time(ctx)) return 0.0f;
+
+    bool moved = false;
+    float best = 0.0f;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        uint32_t gain = 0;
+        Board next    = board_move(board, (Direction)dir, &gain);
+
+        if (next == board) continue;
+
+        float value = move_reward(ctx->config, gain) +
+                      chance_node(ctx, next, depth - 1, prob);
+        if (!moved || value > best) best = value;
+        moved = true;
+    }
+
+    // No legal move: the game is over and nothing more is earned.
+    return best;
+}
+
+static float chance_node(SearchContext* ctx,
+                         Board board,
+                         int depth,
+                         float prob) {
+    ctx->nodes++;
+
+    const Evaluator& eval = ctx->config->eval;
+    int empty             = board_count_empty(board);
+
+    if (depth <= 0 || empty == 0 ||
+        prob < ctx->config->min_probability) {
+        return eval.evaluate(board, eval.ctx);
+    }
+
+    float sum       = 0.0f;
+    float cell_prob = prob / (float)empty;
+    float cached;
+
+    if (cache_lookup(ctx, board, depth, &cached)) return cached;
+
+    for (int i = 0; i < 16; i++) {
+        if (((board >> (4 * i)) & 0xF) != 0) continue;
+
+        Board two  = board | ((Board)1 << (4 * i));
+        Board four = board | ((Board)2 << (4 * i));
+
+        sum += 0.9f * max_node(ctx, two, depth, cell_prob * 0.9f);
+        sum += 0.1f * max_node(ctx, four, depth, cell_prob * 0.1f);
+
+        if (ctx->aborted) return 0.0f;
+    }
+
+    cache_store(ctx, board, depth, sum / (float)empty);
+
+    return sum / (float)empty;
+}
+
+/*
+ * A subtree searched by a pool task, with its own node counter.
+ */
+struct SplitTask {
+    SearchContext ctx;
+    Board board;
+    int depth;
+    float prob;
+    int split_plies;
+    bool chance; // board is an afterstate rather than a spawned one.
+    float value;
+};
+
+static float chance_node_split(SearchContext* ctx,
+                               Board board,
+                               int depth,
+                               float prob,
+                               int split_plies);
+
+static float max_node_split(SearchContext* ctx,
+                            Board board,
+                            int depth,
+                            float prob,
+                            int split_plies) {
+    ctx->nodes++;
+    if (out_of_time(ctx)) return 0.0f;
+
+    bool moved = false;
+    float best = 0.0f;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        uint32_t gain = 0;
+        Board next    = board_move(board, (Direction)dir, &gain);
+
+        if (next == board) continue;
+
+        float value = move_reward(ctx->config, gain) +
+                      chance_node_split(
+                          ctx, next, depth - 1, prob, split_plies - 1);
+        if (!moved || value > best) best = value;
+        moved = true;
+    }
+
+    return best;
+}
+
+static void run_split_task(void* arg) {
+    SplitTask* task = (SplitTask*)arg;
+
+    if (task->chance) {
+        task->value = chance_node_split(&task->ctx,
+                                        task->board,
+                                        task->depth,
+                                        task->prob,
+                                        task->split_plies);
+    } else {
+        task->value = max_node_split(&task->ctx,
+                                     task->board,
+                                     task->depth,
+                                     task->prob,
+                                     task->split_plies);
+    }
+}
+
+static SplitTask make_task(const SearchContext* parent,
+                           Board board,
+                           int depth,
+                           float prob,
+                           int split_plies,
+                           bool chance) {
+    SplitTask task;
+
+    task.ctx            = *parent;
+    task.ctx.nodes      = 0;
+    task.ctx.next_check = DEADLINE_CHECK_INTERVAL;
+    task.ctx.tt_probes  = 0;
+    task.ctx.tt_hits    = 0;
+    task.board          = board;
+    task.depth          = depth;
+    task.prob           = prob;
+    task.split_plies    = split_plies;
+    task.chance         = chance;
+    task.value          = 0.0f;
+
+    return task;
+}
+
+/*
+ * Runs the tasks on the pool and folds their counters back into ctx.
+ */
+static void run_tasks(SearchContext* ctx, vector<SplitTask>& tasks) {
+    TaskGroup group;
+
+    for (SplitTask& task : tasks) {
+        thread_pool_submit(
+            ctx->config->pool, &group, &run_split_task, &task);
+    }
+    thread_pool_wait(ctx->config->pool, &group);
+
+    for (const SplitTask& task : tasks) {
+        ctx->nodes     += task.ctx.nodes;
+        ctx->tt_probes += task.ctx.tt_probes;
+        ctx->tt_hits   += task.ctx.tt_hits;
+        if (task.ctx.aborted) ctx->aborted = true;
+    }
+}
+
+static float chance_node_split(SearchContext* ctx,
+                               Board board,
+                               int depth,
+                               float prob,
+                               int split_plies) {
+    if (split_plies <= 0) return chance_node(ctx, board, depth, prob);
+
+    ctx->nodes++;
+
+    const Evaluator& eval = ctx->config->eval;
+    int empty             = board_count_empty(board);
+
+    if (depth <= 0 || empty == 0 ||
+        prob < ctx->config->min_probability) {
+        return eval.evaluate(board, eval.ctx);
+    }
+
+    float cell_prob = prob / (float)empty;
+    float cached;
+
+    if (cache_lookup(ctx, board, depth, &cached)) return cached;
+
+    vector<SplitTask> tasks;
+    tasks.reserve(2 * empty);
+
+    for (int i = 0; i < 16; i++) {
+        if (((board >> (4 * i)) & 0xF) != 0) continue;
+
+        Board two  = board | ((Board)1 << (4 * i));
+        Board four = board | ((Board)2 << (4 * i));
+
+        tasks.push_back(make_task(
+            ctx, two, depth, cell_prob * 0.9f, split_plies, false));
+        tasks.push_back(make_task(
+            ctx, four, depth, cell_prob * 0.1f, split_plies, false));
+    }
+
+    run_tasks(ctx, tasks);
+    if (ctx->aborted) return 0.0f;
+
+    // Same summation order as chance_node, for identical results.
+    float sum = 0.0f;
+    for (size_t i = 0; i < tasks.size(); i += 2) {
+        sum += 0.9f * tasks[i].value;
+        sum += 0.1f * tasks[i + 1].value;
+    }
+
+    cache_store(ctx, board, depth, sum / (float)empty);
+
+    return sum / (float)empty;
+}
+
+/*
+ * Searches the afterstate of every legal root move to depth and fills
+ * values, rewards included.
+ */
+static void search_root(SearchContext* ctx,
+                        const Board* afters,
+                        const float* rewards,
+                        int legal,
+                        int depth,
+                        float* values) {
+    const SearchConfig* config = ctx->config;
+
+    if (config->pool) {
+        vector<SplitTask> tasks;
+
+        for (int i = 0; i < legal; i++) {
+            tasks.push_back(make_task(ctx,
+                                      afters[i],
+                                      depth - 1,
+                                      1.0f,
+                                      config->split_plies,
+                                      true));
+        }
+
+        run_tasks(ctx, tasks);
+
+        for (int i = 0; i < legal; i++) {
+            values[i] = rewards[i] + tasks[i].value;
+        }
+    } else {
+        for (int i = 0; i < legal && !ctx->aborted; i++) {
+            values[i] = rewards[i] +
+                        chance_node(ctx, afters[i], depth - 1, 1.0f);
+        }
+    }
+}
+
+void ai_search(Board board,
+               const SearchConfig* config,
+               SearchResult* result) {
+    Clock::time_point start = Clock::now();
+    atomic<bool> stop(false);
+
+    SearchContext ctx;
+    ctx.config       = config;
+    ctx.has_deadline = config->budget_us > 0;
+    ctx.deadline     = start + chrono::microseconds(config->budget_us);
+    ctx.aborted      = false;
+    ctx.nodes        = 0;
+    ctx.next_check   = DEADLINE_CHECK_INTERVAL;
+    ctx.stop         = &stop;
+    ctx.cancel       = config->control ? &config->control->cancel : NULL;
+    ctx.tt_probes    = 0;
+    ctx.tt_hits      = 0;
+
+    if (config->tt) tt_new_search(config->tt);
+
+    Direction best     = DIR_COUNT;
+    float best_value   = 0.0f;
+    int best_depth     = 1;
+    Direction dirs[DIR_COUNT];
+    Board afters[DIR_COUNT];
+    float rewards[DIR_COUNT];
+    float values[DIR_COUNT];
+    int legal = 0;
+
+    // The one-ply answer is what we fall back on if time runs out.
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        uint32_t gain = 0;
+        Board next    = board_move(board, (Direction)dir, &gain);
+
+        if (next == board) continue;
+
+        float reward = move_reward(config, gain);
+        float value  = reward + config->eval.evaluate(next, config->eval.ctx);
+        if (best == DIR_COUNT || value > best_value) {
+            best       = (Direction)dir;
+            best_value = value;
+        }
+        dirs[legal]    = (Direction)dir;
+        afters[legal]  = next;
+        rewards[legal] = reward;
+        legal++;
+    }
+
+    publish(config->control, best, best_value, 1);
+
+    // Iterative deepening starts at depth 2, depth 1 being the
+    // fallback itself. Each completed depth replaces the answer.
+    int depth = config->iterative ? 2 : config->max_depth;
+
+    for (; depth <= config->max_depth && legal > 0; depth++) {
+        search_root(&ctx, afters, rewards, legal, depth, values);
+
+        if (ctx.aborted) break;
+
+        Direction depth_best = DIR_COUNT;
+        float depth_value    = 0.0f;
+
+        for (int i = 0; i < legal; i++) {
+            if (depth_best == DIR_COUNT || values[i] > depth_value) {
+                depth_best  = dirs[i];
+                depth_value = values[i];
+            }
+        }
+
+        best       = depth_best;
+        best_value = depth_value;
+        best_depth = depth;
+
+        publish(config->control, best, best_value, depth);
+    }
+
+    uint64_t elapsed_us = (uint64_t)chrono::duration_cast<
+                              chrono::microseconds>(Clock::now() - start)
+                              .count();
+
+    result->best      = best;
+    result->value     = best_value;
+    result->depth     = best_depth;
+    result->timed_out = ctx.aborted;
+    if (config->tt) {
+        tt_record_probes(config->tt, ctx.tt_probes, ctx.tt_hits);
+    }
+
+    result->nodes         = ctx.nodes;
+    result->elapsed_us    = elapsed_us;
+    result->nodes_per_sec = elapsed_us > 0 ?
+        (double)ctx.nodes * 1e6 / (double)elapsed_us :
+        0.0;
+    result->tt_probes = ctx.tt_probes;
+    result->tt_hits   = ctx.tt_hits;
+}
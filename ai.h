@@ -0,0 +1,131 @@
+#ifndef AI_H
+#define AI_H
+
+#include "board.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct ThreadPool;
+struct TransTable;
+
+/*
+ * Lets another thread watch and stop a running search. The search
+ * publishes its answer after every completed depth, so a reader
+ * always has the best move found so far.
+ */
+struct SearchControl {
+    std::atomic<bool> cancel;
+    std::atomic<int> best; // Direction, DIR_COUNT until published.
+    std::atomic<float> value;
+    std::atomic<int> depth; // deepest completed depth, 0 for none.
+};
+
+/*
+ * Scores a board from the point of view of the player about to move.
+ * ctx is passed through untouched so evaluators can carry tables.
+ */
+struct Evaluator {
+    float (*evaluate)(Board board, const void* ctx);
+    const void* ctx;
+};
+
+/*
+ * The same scores for count boards at once, for callers that gather
+ * many positions before scoring them.
+ */
+struct BatchEvaluator {
+    void (*evaluate)(const Board* boards,
+                     float* values,
+                     size_t count,
+                     const void* ctx);
+    const void* ctx;
+};
+
+struct SearchConfig {
+    int max_depth;         // number of player moves to look ahead.
+    uint64_t budget_us;    // wall-clock budget per move, 0 for none.
+    float min_probability; // spawn sequences less likely are cut.
+    Evaluator eval;
+
+    // Rank moves by their merge reward plus the value of the
+    // afterstate, for evaluators that only value what is still to come
+    // (n-tuple networks). Heuristics leave it off.
+    bool add_rewards;
+
+    // When pool is set, the root moves run as parallel tasks and so
+    // do the spawns of the first split_plies chance node levels.
+    ThreadPool* pool;
+    int split_plies;
+
+    // Optional cache of chance node values, shared by all threads and
+    // kept across moves. Each ai_search starts a new generation.
+    TransTable* tt;
+
+    // Search depth 1, 2, ... up to max_depth and keep the deepest
+    // completed answer, instead of going straight to max_depth.
+    bool iterative;
+
+    // Optional, see SearchControl.
+    SearchControl* control;
+};
+
+struct SearchResult {
+    Direction best; // DIR_COUNT when no move is legal.
+    float value;
+    int depth;      // depth the returned move was searched to.
+    bool timed_out; // stopped by the budget or a cancel.
+    uint64_t nodes;
+    uint64_t elapsed_us;
+    double nodes_per_sec;
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+};
+
+/*
+ * Fills config with depth 3, no time budget, the default heuristic
+ * (see heuristic.h) without rewards, no thread pool, no transposition
+ * table, no iterative deepening and no control.
+ */
+void init_search_config(SearchConfig* config);
+
+/*
+ * Clears the cancel flag and the published answer. Must be called
+ * before the control is handed to a search.
+ */
+void init_search_control(SearchControl* control);
+
+/*
+ * Asks the search to stop. Safe from any thread; the search notices
+ * within a few hundred nodes and returns its deepest completed answer.
+ */
+void search_control_cancel(SearchControl* control);
+
+/*
+ * Rewards empty cells and big tiles kept along a snake path that
+ * starts in the top left corner.
+ */
+float evaluate_simple(Board board, const void* ctx);
+
+/*
+ * Expectimax over player moves and tile spawns.
+ *
+ * When the budget runs out or the control cancels before every root
+ * move has been searched to max_depth, the search is abandoned with
+ * timed_out set. It returns the deepest completed answer: the move
+ * with the best one-ply evaluation, or with iterative deepening the
+ * last depth that finished.
+ *
+ * Parallel searches combine child values in the same order as the
+ * serial search, so without a budget the result does not depend on
+ * the number of threads. Node counts are summed over all tasks.
+ * A transposition table gives up that guarantee: a cached value may
+ * come from a path with a different spawn probability cutoff, and
+ * which path stored it first depends on thread timing.
+ */
+void ai_search(Board board,
+               const SearchConfig* config,
+               SearchResult* result);
+
+#endif // !AI_H
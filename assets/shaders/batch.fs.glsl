@@ -0,0 +1,12 @@
+#version 450 core
+
+in vec2 texcoords;
+in vec4 sprite_tint;
+
+out vec4 color;
+
+uniform sampler2D image;
+
+void main() {
+    color = texture(image, texcoords) * sprite_tint;
+}
@@ -0,0 +1,30 @@
+#version 450 core
+
+layout (location = 0) in vec4 vertex;
+
+// Per instance, laid out as SpriteInstance in sprite_batch.h.
+layout (location = 1) in vec4 rect;    // position.xy, size.xy
+layout (location = 2) in vec4 uv_rect; // u0, v0, u1, v1
+layout (location = 3) in vec4 tint;
+layout (location = 4) in float rotation;
+
+out vec2 texcoords;
+out vec4 sprite_tint;
+
+uniform mat4 projection;
+
+
+void main() {
+    // Scale the unit quad to the sprite size, rotate it about its
+    // center, then move its top left corner to rect.xy.
+    vec2 half_size = 0.5 * rect.zw;
+    vec2 local     = vertex.xy * rect.zw - half_size;
+    float c        = cos(rotation);
+    float s        = sin(rotation);
+    vec2 world     = rect.xy + half_size +
+                     vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+    texcoords   = mix(uv_rect.xy, uv_rect.zw, vertex.zw);
+    sprite_tint = tint;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
+}
@@ -0,0 +1,199 @@
+#include "atlas.h"
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "libs/stb_image.h"
+#include "libs/stb_rect_pack.h"
+
+#include <SDL_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+struct AtlasImage {
+    const char* name;
+    int width, height;
+    unsigned char* pixels; // RGBA, from stbi_load.
+};
+
+/*
+ * Copies an image into the atlas at (x, y), the outer corner of its
+ * padding, and repeats its edge pixels out into the padding.
+ */
+static void blit_padded(vector<unsigned char>& atlas,
+                        int atlas_width,
+                        const AtlasImage& image,
+                        int x,
+                        int y) {
+    int padded_width  = image.width + 2 * ATLAS_PADDING;
+    int padded_height = image.height + 2 * ATLAS_PADDING;
+
+    for (int row = 0; row < padded_height; row++) {
+        int src_row = min(max(row - ATLAS_PADDING, 0), image.height - 1);
+
+        for (int col = 0; col < padded_width; col++) {
+            int src_col = min(max(col - ATLAS_PADDING, 0), image.width - 1);
+
+            memcpy(&atlas[4 * ((size_t)(y + row) * atlas_width + x + col)],
+                   &image.pixels[4 * ((size_t)src_row * image.width +
+                                      src_col)],
+                   4);
+        }
+    }
+}
+
+/*
+ * Packs the images into a width by height texture, false when they do
+ * not all fit.
+ */
+static bool pack_images(const vector<AtlasImage>& images,
+                        int width,
+                        int height,
+                        vector<stbrp_rect>& rects) {
+    vector<stbrp_node> nodes(width);
+    stbrp_context context;
+
+    stbrp_init_target(&context, width, height, nodes.data(), width);
+    stbrp_setup_heuristic(&context, STBRP_HEURISTIC_Skyline_BF_sortHeight);
+
+    rects.resize(images.size());
+
+    for (size_t i = 0; i < images.size(); i++) {
+        rects[i].id = (int)i;
+        rects[i].w  = images[i].width + 2 * ATLAS_PADDING;
+        rects[i].h  = images[i].height + 2 * ATLAS_PADDING;
+    }
+
+    return stbrp_pack_rects(&context, rects.data(), (int)rects.size()) == 1;
+}
+
+static int tile_exponent(const char* name) {
+    for (int e = 1; e < ATLAS_TILE_COUNT; e++) {
+        if (to_string(1 << e) == name) return e;
+    }
+    return 0;
+}
+
+GameError build_texture_atlas(
+    TextureAtlas* atlas,
+    const vector<pair<filesystem::path, const char*>>& images) {
+    vector<AtlasImage> loaded;
+    GameError err = GAME_ERROR_NO_ERROR;
+
+    for (const auto& pair : images) {
+        AtlasImage image;
+        int nr_channels;
+
+        // Always 4 channels, the atlas is RGBA whatever the file is.
+        image.name   = pair.second;
+        image.pixels = stbi_load(
+            pair.first.c_str(), &image.width, &image.height, &nr_channels, 4);
+
+        if (!image.pixels) {
+            SDL_Log("Failed to decode image %s: %s\n",
+                    pair.first.c_str(),
+                    stbi_failure_reason());
+            err = GAME_ERROR_IMAGE_DECODING_FAILED;
+            break;
+        }
+
+        loaded.push_back(image);
+    }
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    vector<stbrp_rect> rects;
+    int width = 256, height = 256;
+
+    // Grows the width and the height in turn, so the atlas is at most
+    // twice as wide as it is high.
+    if (err == GAME_ERROR_NO_ERROR) {
+        while (!pack_images(loaded, width, height, rects)) {
+            if (width == height) {
+                width *= 2;
+            } else {
+                height *= 2;
+            }
+
+            if (width > max_size) {
+                SDL_Log("Images do not fit a %dx%d texture atlas.\n",
+                        max_size,
+                        max_size);
+                err = GAME_ERROR_ATLAS_PACKING_FAILED;
+                break;
+            }
+        }
+    }
+
+    if (err != GAME_ERROR_NO_ERROR) {
+        for (const AtlasImage& image : loaded) stbi_image_free(image.pixels);
+        return err;
+    }
+
+    vector<unsigned char> pixels(4 * (size_t)width * height, 0);
+
+    atlas->width  = width;
+    atlas->height = height;
+    atlas->regions.clear();
+    memset(atlas->tile_uv, 0, sizeof(atlas->tile_uv));
+
+    for (const stbrp_rect& rect : rects) {
+        const AtlasImage& image = loaded[rect.id];
+
+        blit_padded(pixels, width, image, rect.x, rect.y);
+
+        AtlasRegion region;
+
+        region.x      = rect.x + ATLAS_PADDING;
+        region.y      = rect.y + ATLAS_PADDING;
+        region.width  = image.width;
+        region.height = image.height;
+        region.uv     = { (float)region.x / width,
+                          (float)region.y / height,
+                          (float)(region.x + region.width) / width,
+                          (float)(region.y + region.height) / height };
+
+        atlas->regions[image.name] = region;
+
+        int e = tile_exponent(image.name);
+        if (e > 0) atlas->tile_uv[e] = region.uv;
+
+        stbi_image_free(image.pixels);
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &atlas->texture);
+
+    glTextureParameteri(atlas->texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(atlas->texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(atlas->texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(atlas->texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTextureStorage2D(atlas->texture, 1, GL_RGBA8, width, height);
+    glTextureSubImage2D(atlas->texture,
+                        0,
+                        0,
+                        0,
+                        width,
+                        height,
+                        GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        pixels.data());
+
+    SDL_Log("Packed %d images into a %dx%d texture atlas, OpenGL handle: "
+            "%d\n",
+            (int)rects.size(),
+            width,
+            height,
+            atlas->texture);
+
+    return GAME_ERROR_NO_ERROR;
+}
+
+void destroy_texture_atlas(TextureAtlas* atlas) {
+    glDeleteTextures(1, &atlas->texture);
+
+    atlas->texture = 0;
+    atlas->regions.clear();
+}
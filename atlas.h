@@ -0,0 +1,52 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "math.h"
+#include "utils.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL_opengl.h>
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Tile exponents 1 (the "2" tile) through 11 (the "2048" tile).
+const int ATLAS_TILE_COUNT = 12;
+
+// Border around every image, a copy of its edge pixels, so linear
+// filtering at an edge never blends in a neighbouring image.
+const int ATLAS_PADDING = 1;
+
+struct AtlasRegion {
+    Vec4 uv; // u0, v0, u1, v1, as SpriteInstance takes them.
+    int x, y, width, height;
+};
+
+/*
+ * Every image of the game packed into one RGBA texture, so sprites of
+ * different images still share a texture and a batched draw.
+ */
+struct TextureAtlas {
+    GLuint texture;
+    int width, height;
+    std::unordered_map<std::string, AtlasRegion> regions;
+    // Regions of the tile images by exponent, zero where there is none.
+    Vec4 tile_uv[ATLAS_TILE_COUNT];
+};
+
+/*
+ * Loads the images, packs them with stb_rect_pack into the smallest
+ * power of two texture they fit, and uploads it. Images are
+ * named by the second element of each pair; a name that is a tile
+ * value ("2" .. "2048") also fills tile_uv.
+ */
+GameError build_texture_atlas(
+    TextureAtlas* atlas,
+    const std::vector<std::pair<std::filesystem::path, const char*>>& images);
+
+void destroy_texture_atlas(TextureAtlas* atlas);
+
+#endif // !ATLAS_H
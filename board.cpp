@@ -0,0 +1,195 @@
+#include "./board.h"
+#include "./board_tables.h"
+
+
+int board_get_tile(Board board, int row, int col) {
+    return (int)((board >> (4 * (row * 4 + col))) & 0xF);
+}
+
+Board board_set_tile(Board board, int row, int col, int exp) {
+    int shift = 4 * (row * 4 + col);
+
+    board &= ~((Board)0xF << shift);
+    board |= (Board)(exp & 0xF) << shift;
+
+    return board;
+}
+
+/*
+ * Slides line[0..3] toward line[0], merging each pair of equal tiles
+ * at most once. Returns true if anything moved.
+ */
+static bool move_line(int line[4], uint32_t* score) {
+    int out[4]     = { 0, 0, 0, 0 };
+    int n          = 0;
+    bool can_merge = false;
+    bool moved     = false;
+
+    for (int i = 0; i < 4; i++) {
+        if (line[i] == 0) continue;
+
+        // 0xF tiles can't merge, the nibble has no room for 0x10.
+        if (can_merge && out[n - 1] == line[i] && line[i] != 0xF) {
+            out[n - 1]++;
+            if (score) *score += 1u << out[n - 1];
+            can_merge = false;
+        } else {
+            out[n++]  = line[i];
+            can_merge = true;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (out[i] != line[i]) moved = true;
+        line[i] = out[i];
+    }
+
+    return moved;
+}
+
+uint16_t row_move_table[ROW_MOVE_TABLE_SIZE];
+uint32_t row_score_table[65536];
+
+static uint16_t* const row_left_table  = row_move_table;
+static uint16_t* const row_right_table = row_move_table + 65536;
+
+// Bit 0 is set when a left move changes the row, bit 1 for right.
+static uint8_t row_changed_table[65536];
+
+static uint16_t reverse_row(uint16_t row) {
+    return (uint16_t)((row >> 12) | ((row >> 4) & 0x00F0) |
+                      ((row << 4) & 0x0F00) | (row << 12));
+}
+
+void init_board_tables() {
+    for (uint32_t row = 0; row < 65536; row++) {
+        int line[4];
+        uint32_t score = 0;
+
+        for (int i = 0; i < 4; i++) line[i] = (row >> (4 * i)) & 0xF;
+
+        move_line(line, &score);
+
+        uint16_t left = 0;
+        for (int i = 0; i < 4; i++) left |= line[i] << (4 * i);
+
+        uint16_t rev = reverse_row((uint16_t)row);
+        row_left_table[row]  = left;
+        row_score_table[row] = score;
+        row_right_table[rev] = reverse_row(left);
+    }
+
+    for (uint32_t row = 0; row < 65536; row++) {
+        row_changed_table[row] =
+            (row_left_table[row] != row ? 1 : 0) |
+            (row_right_table[row] != row ? 2 : 0);
+    }
+}
+
+Board board_transpose(Board board) {
+    Board a1 = board & 0xF0F00F0FF0F00F0FULL;
+    Board a2 = board & 0x0000F0F00000F0F0ULL;
+    Board a3 = board & 0x0F0F00000F0F0000ULL;
+    Board a  = a1 | (a2 << 12) | (a3 >> 12);
+    Board b1 = a & 0xFF00FF0000FF00FFULL;
+    Board b2 = a & 0x00FF00FF00000000ULL;
+    Board b3 = a & 0x00000000FF00FF00ULL;
+
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+static Board move_rows(Board board,
+                       const uint16_t* table,
+                       uint32_t* score) {
+    Board out = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint16_t row = (uint16_t)(board >> (16 * i));
+
+        out |= (Board)table[row] << (16 * i);
+        if (score) *score += row_score_table[row];
+    }
+
+    return out;
+}
+
+Board board_move(Board board, Direction dir, uint32_t* score) {
+    switch (dir) {
+        case DIR_LEFT: return move_rows(board, row_left_table, score);
+        case DIR_RIGHT:
+            return move_rows(board, row_right_table, score);
+        case DIR_UP:
+            return board_transpose(move_rows(
+                board_transpose(board), row_left_table, score));
+        case DIR_DOWN:
+            return board_transpose(move_rows(
+                board_transpose(board), row_right_table, score));
+        default: return board;
+    }
+}
+
+static bool rows_changed(Board board, int mask) {
+    return ((row_changed_table[(uint16_t)board] |
+             row_changed_table[(uint16_t)(board >> 16)] |
+             row_changed_table[(uint16_t)(board >> 32)] |
+             row_changed_table[(uint16_t)(board >> 48)]) &
+            mask) != 0;
+}
+
+bool board_can_move(Board board, Direction dir) {
+    switch (dir) {
+        case DIR_LEFT: return rows_changed(board, 1);
+        case DIR_RIGHT: return rows_changed(board, 2);
+        case DIR_UP: return rows_changed(board_transpose(board), 1);
+        case DIR_DOWN: return rows_changed(board_transpose(board), 2);
+        default: return false;
+    }
+}
+
+int board_count_empty(Board board) {
+    if (board == 0) return 16;
+
+    // Fold every nibble into its low bit, set when the nibble is 0.
+    board |= (board >> 2) & 0x3333333333333333ULL;
+    board |= (board >> 1);
+    board = ~board & 0x1111111111111111ULL;
+
+    // Sums the 16 bits into the top nibble. A full 16 would wrap to
+    // 0, which is the board == 0 case handled above.
+    return (int)((board * 0x1111111111111111ULL) >> 60);
+}
+
+Board board_spawn(Board board, uint32_t rand_bits) {
+    int empty = board_count_empty(board);
+
+    if (empty == 0) return board;
+
+    // Low 16 bits pick the cell, high 16 bits pick the value.
+    int nth = (int)(((rand_bits & 0xFFFF) * (uint32_t)empty) >> 16);
+    Board exp = ((rand_bits >> 16) % 10 == 0) ? 2 : 1;
+
+    for (int i = 0; i < 16; i++) {
+        if (((board >> (4 * i)) & 0xF) != 0) continue;
+        if (nth-- == 0) return board | (exp << (4 * i));
+    }
+
+    return board;
+}
+
+bool board_is_game_over(Board board) {
+    if (board_count_empty(board) > 0) return false;
+
+    return !rows_changed(board, 3) &&
+           !rows_changed(board_transpose(board), 3);
+}
+
+int board_max_tile(Board board) {
+    int max = 0;
+
+    for (int i = 0; i < 16; i++) {
+        int tile = (int)((board >> (4 * i)) & 0xF);
+        if (tile > max) max = tile;
+    }
+
+    return max;
+}
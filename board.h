@@ -0,0 +1,60 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * A 4x4 board packed into a single 64-bit word.
+ *
+ * Every tile is stored as a 4-bit exponent (0 is an empty cell,
+ * 1 is a 2 tile, 2 is a 4 tile, ... 15 is a 32768 tile). Tile
+ * (row, col) lives in nibble row * 4 + col, so row 0 occupies the
+ * low 16 bits and col 0 is the low nibble of every row.
+ */
+typedef uint64_t Board;
+
+enum Direction { DIR_UP, DIR_DOWN, DIR_LEFT, DIR_RIGHT, DIR_COUNT };
+
+/*
+ * Builds the row transition tables every move goes through.
+ * Must be called once before any other board function.
+ */
+void init_board_tables();
+
+int board_get_tile(Board board, int row, int col);
+
+Board board_set_tile(Board board, int row, int col, int exp);
+
+/*
+ * Slides and merges every tile in the given direction.
+ *
+ * Returns the resulting board (equal to the input when the move is
+ * illegal). The value of the merged tiles is added to *score when
+ * score is not NULL.
+ */
+Board board_move(Board board, Direction dir, uint32_t* score);
+
+/*
+ * Swaps rows and columns, so column moves can reuse the row tables.
+ */
+Board board_transpose(Board board);
+
+bool board_can_move(Board board, Direction dir);
+
+int board_count_empty(Board board);
+
+/*
+ * Places a new tile on a random empty cell: a 2 with 90% and a 4
+ * with 10% probability. The caller supplies the 32 random bits so
+ * the board itself stays deterministic.
+ *
+ * Returns the board unchanged when it has no empty cell.
+ */
+Board board_spawn(Board board, uint32_t rand_bits);
+
+bool board_is_game_over(Board board);
+
+int board_max_tile(Board board);
+
+#endif // !BOARD_H
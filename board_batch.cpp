@@ -0,0 +1,278 @@
+#include "./board_batch.h"
+#include "./board_tables.h"
+
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BOARD_BATCH_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+
+static void move_batch_scalar(const Board* boards,
+                              const Direction* dirs,
+                              Board* out,
+                              uint32_t* scores,
+                              size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t score = 0;
+
+        out[i] = board_move(boards[i], dirs[i], &score);
+        if (scores) scores[i] = score;
+    }
+}
+
+#ifdef BOARD_BATCH_X86
+
+// The AVX2 kernel loads four directions as packed 32-bit lanes.
+static_assert(sizeof(Direction) == sizeof(int32_t),
+              "Direction must be 32 bits wide");
+
+/*
+ * Same bit shuffle as board_transpose, on every 64-bit lane.
+ */
+TARGET_AVX2 static inline __m256i transpose_avx2(__m256i b) {
+    const __m256i m1 = _mm256_set1_epi64x(0xF0F00F0FF0F00F0FLL);
+    const __m256i m2 = _mm256_set1_epi64x(0x0000F0F00000F0F0LL);
+    const __m256i m3 = _mm256_set1_epi64x(0x0F0F00000F0F0000LL);
+    const __m256i m4 = _mm256_set1_epi64x(0xFF00FF0000FF00FFLL);
+    const __m256i m5 = _mm256_set1_epi64x(0x00FF00FF00000000LL);
+    const __m256i m6 = _mm256_set1_epi64x(0x00000000FF00FF00LL);
+
+    __m256i a = _mm256_or_si256(
+        _mm256_and_si256(b, m1),
+        _mm256_or_si256(
+            _mm256_slli_epi64(_mm256_and_si256(b, m2), 12),
+            _mm256_srli_epi64(_mm256_and_si256(b, m3), 12)));
+
+    return _mm256_or_si256(
+        _mm256_and_si256(a, m4),
+        _mm256_or_si256(
+            _mm256_srli_epi64(_mm256_and_si256(a, m5), 24),
+            _mm256_slli_epi64(_mm256_and_si256(a, m6), 24)));
+}
+
+/*
+ * Moves row Shift / 16 of four boards through the tables. offset is
+ * 65536 in lanes moving right (or down), which selects the right half
+ * of row_move_table.
+ */
+template <int Shift>
+TARGET_AVX2 static inline void move_row_avx2(__m256i b,
+                                             __m256i offset,
+                                             __m256i* out,
+                                             __m128i* score) {
+    const __m256i row_mask = _mm256_set1_epi64x(0xFFFF);
+    const __m128i lo_mask  = _mm_set1_epi32(0xFFFF);
+
+    __m256i row =
+        _mm256_and_si256(_mm256_srli_epi64(b, Shift), row_mask);
+
+    __m128i moved = _mm256_i64gather_epi32(
+        (const int*)row_move_table, _mm256_add_epi64(row, offset), 2);
+    moved = _mm_and_si128(moved, lo_mask);
+
+    *out = _mm256_or_si256(
+        *out, _mm256_slli_epi64(_mm256_cvtepu32_epi64(moved), Shift));
+
+    *score = _mm_add_epi32(
+        *score,
+        _mm256_i64gather_epi32((const int*)row_score_table, row, 4));
+}
+
+TARGET_AVX2 static void move_batch_avx2(const Board* boards,
+                                        const Direction* dirs,
+                                        Board* out,
+                                        uint32_t* scores,
+                                        size_t count) {
+    const __m256i one      = _mm256_set1_epi64x(1);
+    const __m256i dir_left = _mm256_set1_epi64x(DIR_LEFT);
+    size_t i               = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m256i b = _mm256_loadu_si256((const __m256i*)(boards + i));
+        __m256i d = _mm256_cvtepi32_epi64(
+            _mm_loadu_si128((const __m128i*)(dirs + i)));
+
+        // DIR_UP and DIR_DOWN sort before DIR_LEFT and work on the
+        // transposed board. DIR_DOWN and DIR_RIGHT are odd and use
+        // the right-move half of the table.
+        __m256i vertical = _mm256_cmpgt_epi64(dir_left, d);
+        __m256i offset =
+            _mm256_slli_epi64(_mm256_and_si256(d, one), 16);
+
+        b = _mm256_blendv_epi8(b, transpose_avx2(b), vertical);
+
+        __m256i moved = _mm256_setzero_si256();
+        __m128i score = _mm_setzero_si128();
+
+        move_row_avx2<0>(b, offset, &moved, &score);
+        move_row_avx2<16>(b, offset, &moved, &score);
+        move_row_avx2<32>(b, offset, &moved, &score);
+        move_row_avx2<48>(b, offset, &moved, &score);
+
+        moved =
+            _mm256_blendv_epi8(moved, transpose_avx2(moved), vertical);
+
+        _mm256_storeu_si256((__m256i*)(out + i), moved);
+        if (scores) _mm_storeu_si128((__m128i*)(scores + i), score);
+    }
+
+    move_batch_scalar(boards + i,
+                      dirs + i,
+                      out + i,
+                      scores ? scores + i : NULL,
+                      count - i);
+}
+
+TARGET_SSE42 static inline __m128i transpose_sse42(__m128i b) {
+    const __m128i m1 = _mm_set1_epi64x(0xF0F00F0FF0F00F0FLL);
+    const __m128i m2 = _mm_set1_epi64x(0x0000F0F00000F0F0LL);
+    const __m128i m3 = _mm_set1_epi64x(0x0F0F00000F0F0000LL);
+    const __m128i m4 = _mm_set1_epi64x(0xFF00FF0000FF00FFLL);
+    const __m128i m5 = _mm_set1_epi64x(0x00FF00FF00000000LL);
+    const __m128i m6 = _mm_set1_epi64x(0x00000000FF00FF00LL);
+
+    __m128i a = _mm_or_si128(
+        _mm_and_si128(b, m1),
+        _mm_or_si128(_mm_slli_epi64(_mm_and_si128(b, m2), 12),
+                     _mm_srli_epi64(_mm_and_si128(b, m3), 12)));
+
+    return _mm_or_si128(
+        _mm_and_si128(a, m4),
+        _mm_or_si128(_mm_srli_epi64(_mm_and_si128(a, m5), 24),
+                     _mm_slli_epi64(_mm_and_si128(a, m6), 24)));
+}
+
+/*
+ * Looks up 16-bit lane Lane (row Lane % 4 of board Lane / 4).
+ */
+template <int Lane>
+TARGET_SSE42 static inline __m128i move_row_sse42(__m128i b,
+                                                  __m128i moved,
+                                                  const int* offset,
+                                                  uint32_t* score) {
+    int row = _mm_extract_epi16(b, Lane);
+
+    score[Lane / 4] += row_score_table[row];
+
+    return _mm_insert_epi16(
+        moved, row_move_table[offset[Lane / 4] + row], Lane);
+}
+
+TARGET_SSE42 static void move_batch_sse42(const Board* boards,
+                                          const Direction* dirs,
+                                          Board* out,
+                                          uint32_t* scores,
+                                          size_t count) {
+    size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i b = _mm_loadu_si128((const __m128i*)(boards + i));
+
+        __m128i vertical = _mm_set_epi64x(
+            dirs[i + 1] < DIR_LEFT ? -1 : 0, dirs[i] < DIR_LEFT ? -1 : 0);
+        int offset[2]     = { (dirs[i] & 1) << 16,
+                              (dirs[i + 1] & 1) << 16 };
+        uint32_t score[2] = { 0, 0 };
+
+        b = _mm_blendv_epi8(b, transpose_sse42(b), vertical);
+
+        __m128i moved = _mm_setzero_si128();
+
+        moved = move_row_sse42<0>(b, moved, offset, score);
+        moved = move_row_sse42<1>(b, moved, offset, score);
+        moved = move_row_sse42<2>(b, moved, offset, score);
+        moved = move_row_sse42<3>(b, moved, offset, score);
+        moved = move_row_sse42<4>(b, moved, offset, score);
+        moved = move_row_sse42<5>(b, moved, offset, score);
+        moved = move_row_sse42<6>(b, moved, offset, score);
+        moved = move_row_sse42<7>(b, moved, offset, score);
+
+        moved = _mm_blendv_epi8(moved, transpose_sse42(moved), vertical);
+
+        _mm_storeu_si128((__m128i*)(out + i), moved);
+        if (scores) {
+            scores[i]     = score[0];
+            scores[i + 1] = score[1];
+        }
+    }
+
+    move_batch_scalar(boards + i,
+                      dirs + i,
+                      out + i,
+                      scores ? scores + i : NULL,
+                      count - i);
+}
+
+#endif // BOARD_BATCH_X86
+
+
+static bool kernel_supported(BatchKernel kernel) {
+    switch (kernel) {
+        case BATCH_KERNEL_SCALAR: return true;
+#ifdef BOARD_BATCH_X86
+        case BATCH_KERNEL_SSE42: return __builtin_cpu_supports("sse4.2");
+        case BATCH_KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+static BatchKernel detect_kernel() {
+    if (kernel_supported(BATCH_KERNEL_AVX2)) return BATCH_KERNEL_AVX2;
+    if (kernel_supported(BATCH_KERNEL_SSE42)) return BATCH_KERNEL_SSE42;
+    return BATCH_KERNEL_SCALAR;
+}
+
+static std::atomic<int> current_kernel(-1);
+
+BatchKernel board_batch_kernel() {
+    int kernel = current_kernel.load(std::memory_order_relaxed);
+
+    if (kernel < 0) {
+        kernel = detect_kernel();
+        current_kernel.store(kernel, std::memory_order_relaxed);
+    }
+
+    return (BatchKernel)kernel;
+}
+
+BatchKernel board_batch_set_kernel(BatchKernel kernel) {
+    while (!kernel_supported(kernel)) kernel = (BatchKernel)(kernel - 1);
+
+    current_kernel.store(kernel, std::memory_order_relaxed);
+
+    return kernel;
+}
+
+const char* board_batch_kernel_name(BatchKernel kernel) {
+    switch (kernel) {
+        case BATCH_KERNEL_SCALAR: return "scalar";
+        case BATCH_KERNEL_SSE42: return "sse4.2";
+        case BATCH_KERNEL_AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+void board_move_batch(const Board* boards,
+                      const Direction* dirs,
+                      Board* out,
+                      uint32_t* scores,
+                      size_t count) {
+    switch (board_batch_kernel()) {
+#ifdef BOARD_BATCH_X86
+        case BATCH_KERNEL_AVX2:
+            move_batch_avx2(boards, dirs, out, scores, count);
+            break;
+        case BATCH_KERNEL_SSE42:
+            move_batch_sse42(boards, dirs, out, scores, count);
+            break;
+#endif
+        default:
+            move_batch_scalar(boards, dirs, out, scores, count);
+            break;
+    }
+}
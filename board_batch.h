@@ -0,0 +1,42 @@
+#ifndef BOARD_BATCH_H
+#define BOARD_BATCH_H
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum BatchKernel {
+    BATCH_KERNEL_SCALAR,
+    BATCH_KERNEL_SSE42,
+    BATCH_KERNEL_AVX2
+};
+
+/*
+ * Applies dirs[i] to boards[i] for every i < count and writes the
+ * result to out[i], which may alias boards. When scores is not NULL
+ * scores[i] is set to the score gained by that move.
+ *
+ * The kernel is picked on first use from what the CPU supports:
+ * AVX2 moves four boards per iteration with gathered table lookups,
+ * SSE4.2 transposes two boards at once and looks rows up one by one,
+ * and the scalar kernel is plain board_move.
+ */
+void board_move_batch(const Board* boards,
+                      const Direction* dirs,
+                      Board* out,
+                      uint32_t* scores,
+                      size_t count);
+
+BatchKernel board_batch_kernel();
+
+/*
+ * Overrides the detected kernel, falling back to the best supported
+ * one when the CPU lacks the requested instructions. Returns the
+ * kernel actually selected.
+ */
+BatchKernel board_batch_set_kernel(BatchKernel kernel);
+
+const char* board_batch_kernel_name(BatchKernel kernel);
+
+#endif // !BOARD_BATCH_H
@@ -0,0 +1,410 @@
+#ifndef BOARD_N_H
+#define BOARD_N_H
+
+#include "board.h"
+
+#include <cstdint>
+
+/*
+ * An NxN board, packed the same way as the 4x4 Board: every tile is a
+ * 4-bit exponent and a row is 4 * N bits with col 0 in the low nibble.
+ *
+ * Rows never straddle two words. 2x2 to 4x4 boards fit in one 64-bit
+ * word, 5x5 takes two (128 bits) and 6x6 to 8x8 take three or four.
+ * BoardN<4> has exactly the layout of Board and every operation on
+ * it forwards to the board.h engine.
+ *
+ * Row moves go through tables where they stay small: built at compile
+ * time for 2x2 and 3x3 (256 and 4096 rows), at first use for 5x5 (1M
+ * rows, 12 MB). Wider rows have no table and are slid by a plain loop
+ * over their N tiles, one per direction (see row_n_move_right).
+ *
+ * Like the 4x4 engine, tiles stop merging at exponent 15 (32768).
+ */
+template <int N>
+struct BoardN {
+    static_assert(N >= 2 && N <= 8, "boards go from 2x2 to 8x8");
+
+    static constexpr int ROW_BITS      = 4 * N;
+    static constexpr int ROWS_PER_WORD = 64 / ROW_BITS;
+    static constexpr int WORDS =
+        (N + ROWS_PER_WORD - 1) / ROWS_PER_WORD;
+    static constexpr uint64_t ROW_MASK = (1ULL << ROW_BITS) - 1;
+
+    uint64_t words[WORDS];
+};
+
+template <int N>
+bool operator==(const BoardN<N>& a, const BoardN<N>& b) {
+    for (int i = 0; i < BoardN<N>::WORDS; i++) {
+        if (a.words[i] != b.words[i]) return false;
+    }
+    return true;
+}
+
+template <int N>
+bool operator!=(const BoardN<N>& a, const BoardN<N>& b) {
+    return !(a == b);
+}
+
+template <int N>
+uint32_t board_n_get_row(const BoardN<N>& board, int row) {
+    typedef BoardN<N> B;
+
+    int shift = (row % B::ROWS_PER_WORD) * B::ROW_BITS;
+
+    return (uint32_t)((board.words[row / B::ROWS_PER_WORD] >> shift) &
+                      B::ROW_MASK);
+}
+
+template <int N>
+void board_n_set_row(BoardN<N>* board, int row, uint32_t value) {
+    typedef BoardN<N> B;
+
+    int shift      = (row % B::ROWS_PER_WORD) * B::ROW_BITS;
+    uint64_t& word = board->words[row / B::ROWS_PER_WORD];
+
+    word &= ~(B::ROW_MASK << shift);
+    word |= ((uint64_t)value & B::ROW_MASK) << shift;
+}
+
+template <int N>
+int board_n_get_tile(const BoardN<N>& board, int row, int col) {
+    return (int)((board_n_get_row(board, row) >> (4 * col)) & 0xF);
+}
+
+template <int N>
+void board_n_set_tile(BoardN<N>* board, int row, int col, int exp) {
+    uint32_t value = board_n_get_row(*board, row);
+
+    value &= ~(0xFu << (4 * col));
+    value |= (uint32_t)(exp & 0xF) << (4 * col);
+
+    board_n_set_row(board, row, value);
+}
+
+/*
+ * Slides an N-tile row toward col 0. Usable at compile time, which is
+ * how the small tables get built.
+ */
+template <int N>
+constexpr uint32_t row_n_move_left(uint32_t row, uint32_t* score) {
+    uint32_t out   = 0;
+    int n          = 0;
+    int last       = 0;
+    bool can_merge = false;
+
+    for (int i = 0; i < N; i++) {
+        int tile = (int)((row >> (4 * i)) & 0xF);
+
+        if (tile == 0) continue;
+
+        if (can_merge && tile == last && tile != 0xF) {
+            out += 1u << (4 * (n - 1));
+            *score += 1u << (tile + 1);
+            can_merge = false;
+        } else {
+            out |= (uint32_t)tile << (4 * n);
+            n++;
+            last      = tile;
+            can_merge = true;
+        }
+    }
+
+    return out;
+}
+
+/*
+ * row_n_move_left mirrored: slides toward col N - 1 by scanning from
+ * that end, so a right move on a wide row needs no reversing.
+ */
+template <int N>
+constexpr uint32_t row_n_move_right(uint32_t row, uint32_t* score) {
+    uint32_t out   = 0;
+    int n          = N - 1;
+    int last       = 0;
+    bool can_merge = false;
+
+    for (int i = N - 1; i >= 0; i--) {
+        int tile = (int)((row >> (4 * i)) & 0xF);
+
+        if (tile == 0) continue;
+
+        if (can_merge && tile == last && tile != 0xF) {
+            out += 1u << (4 * (n + 1));
+            *score += 1u << (tile + 1);
+            can_merge = false;
+        } else {
+            out |= (uint32_t)tile << (4 * n);
+            n--;
+            last      = tile;
+            can_merge = true;
+        }
+    }
+
+    return out;
+}
+
+template <int N>
+constexpr uint32_t row_n_reverse(uint32_t row) {
+    uint32_t out = 0;
+
+    for (int i = 0; i < N; i++) {
+        out |= ((row >> (4 * i)) & 0xF) << (4 * (N - 1 - i));
+    }
+
+    return out;
+}
+
+template <int N>
+struct RowTableN {
+    static constexpr uint32_t SIZE = 1u << (4 * N);
+
+    uint32_t left[SIZE];
+    uint32_t right[SIZE];
+    uint32_t score[SIZE];
+};
+
+template <int N>
+constexpr void fill_row_table_n(RowTableN<N>* table) {
+    for (uint32_t row = 0; row < RowTableN<N>::SIZE; row++) {
+        uint32_t score = 0;
+        uint32_t left  = row_n_move_left<N>(row, &score);
+
+        table->left[row]  = left;
+        table->score[row] = score;
+
+        table->right[row_n_reverse<N>(row)] = row_n_reverse<N>(left);
+    }
+}
+
+template <int N>
+constexpr RowTableN<N> make_row_table_n() {
+    RowTableN<N> table{};
+    fill_row_table_n<N>(&table);
+    return table;
+}
+
+template <int N>
+const RowTableN<N>* row_table_n() {
+    static_assert(N <= 3 || N == 5, "no row table for this size");
+
+    if constexpr (N <= 3) {
+        static constexpr RowTableN<N> table = make_row_table_n<N>();
+        return &table;
+    } else {
+        // Too big to build at compile time or on the stack.
+        static const RowTableN<N>* table = [] {
+            RowTableN<N>* t = new RowTableN<N>;
+            fill_row_table_n<N>(t);
+            return t;
+        }();
+        return table;
+    }
+}
+
+template <int N>
+uint32_t row_n_move(uint32_t row, bool right, uint32_t* score) {
+    if constexpr (N <= 3 || N == 5) {
+        const RowTableN<N>* table = row_table_n<N>();
+
+        *score += table->score[row];
+        return right ? table->right[row] : table->left[row];
+    } else {
+        return right ? row_n_move_right<N>(row, score) :
+                       row_n_move_left<N>(row, score);
+    }
+}
+
+template <int N>
+BoardN<N> board_n_transpose(const BoardN<N>& board) {
+    BoardN<N> out = {};
+
+    if constexpr (N == 4) {
+        out.words[0] = board_transpose(board.words[0]);
+    } else {
+        for (int col = 0; col < N; col++) {
+            uint32_t value = 0;
+
+            for (int row = 0; row < N; row++) {
+                value |= (uint32_t)board_n_get_tile(board, row, col)
+                         << (4 * row);
+            }
+            board_n_set_row(&out, col, value);
+        }
+    }
+
+    return out;
+}
+
+/*
+ * Same contract as board_move: returns the input unchanged for an
+ * illegal move and adds the merged value to *score when not NULL.
+ */
+template <int N>
+BoardN<N> board_n_move(const BoardN<N>& board,
+                       Direction dir,
+                       uint32_t* score) {
+    if constexpr (N == 4) {
+        BoardN<4> out;
+        out.words[0] = board_move(board.words[0], dir, score);
+        return out;
+    } else {
+        if (dir < 0 || dir >= DIR_COUNT) return board;
+
+        bool vertical = dir == DIR_UP || dir == DIR_DOWN;
+        bool right    = dir == DIR_RIGHT || dir == DIR_DOWN;
+
+        BoardN<N> src = vertical ? board_n_transpose(board) : board;
+        BoardN<N> out = {};
+        uint32_t gain = 0;
+
+        for (int row = 0; row < N; row++) {
+            board_n_set_row(
+                &out,
+                row,
+                row_n_move<N>(board_n_get_row(src, row), right, &gain));
+        }
+
+        if (score) *score += gain;
+
+        return vertical ? board_n_transpose(out) : out;
+    }
+}
+
+template <int N>
+bool board_n_can_move(const BoardN<N>& board, Direction dir) {
+    return board_n_move(board, dir, (uint32_t*)NULL) != board;
+}
+
+template <int N>
+int board_n_count_empty(const BoardN<N>& board) {
+    if constexpr (N == 4) {
+        return board_count_empty(board.words[0]);
+    } else {
+        int empty = 0;
+
+        for (int row = 0; row < N; row++) {
+            uint32_t value = board_n_get_row(board, row);
+
+            for (int col = 0; col < N; col++) {
+                if (((value >> (4 * col)) & 0xF) == 0) empty++;
+            }
+        }
+
+        return empty;
+    }
+}
+
+/*
+ * Same draw as board_spawn: the low 16 random bits pick the empty
+ * cell, the high 16 bits make it a 4 one time in ten.
+ */
+template <int N>
+BoardN<N> board_n_spawn(const BoardN<N>& board, uint32_t rand_bits) {
+    int empty = board_n_count_empty(board);
+
+    if (empty == 0) return board;
+
+    int nth = (int)(((rand_bits & 0xFFFF) * (uint32_t)empty) >> 16);
+    int exp = ((rand_bits >> 16) % 10 == 0) ? 2 : 1;
+
+    BoardN<N> out = board;
+
+    for (int row = 0; row < N; row++) {
+        for (int col = 0; col < N; col++) {
+            if (board_n_get_tile(board, row, col) != 0) continue;
+
+            if (nth-- == 0) {
+                board_n_set_tile(&out, row, col, exp);
+                return out;
+            }
+        }
+    }
+
+    return out;
+}
+
+template <int N>
+bool board_n_is_game_over(const BoardN<N>& board) {
+    if (board_n_count_empty(board) > 0) return false;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        if (board_n_can_move(board, (Direction)dir)) return false;
+    }
+
+    return true;
+}
+
+template <int N>
+int board_n_max_tile(const BoardN<N>& board) {
+    int max = 0;
+
+    for (int row = 0; row < N; row++) {
+        for (int col = 0; col < N; col++) {
+            int tile = board_n_get_tile(board, row, col);
+            if (tile > max) max = tile;
+        }
+    }
+
+    return max;
+}
+
+/*
+ * Mirrors columns when symmetry & 1 and rows when symmetry & 2, the
+ * part of a symmetry applied after the optional transpose.
+ */
+template <int N>
+BoardN<N> board_n_mirror(const BoardN<N>& board, int symmetry) {
+    BoardN<N> out = {};
+
+    for (int row = 0; row < N; row++) {
+        uint32_t value = board_n_get_row(board, row);
+
+        if (symmetry & 1) value = row_n_reverse<N>(value);
+        board_n_set_row(&out, (symmetry & 2) ? N - 1 - row : row, value);
+    }
+
+    return out;
+}
+
+/*
+ * The 8 symmetries of the square, numbered as in symmetry.h so that
+ * symmetry_map_direction and symmetry_unmap_direction apply as is.
+ */
+template <int N>
+BoardN<N> board_n_symmetry(const BoardN<N>& board, int symmetry) {
+    BoardN<N> b = symmetry >= 4 ? board_n_transpose(board) : board;
+
+    return board_n_mirror(b, symmetry);
+}
+
+/*
+ * The image with the smallest words, compared from the last word.
+ * When symmetry is not NULL it gets the s that maps board to it.
+ */
+template <int N>
+BoardN<N> board_n_canonical(const BoardN<N>& board, int* symmetry) {
+    BoardN<N> transposed = board_n_transpose(board);
+    BoardN<N> best       = board;
+    int best_s           = 0;
+
+    for (int s = 1; s < 8; s++) {
+        BoardN<N> image = board_n_mirror(s >= 4 ? transposed : board, s);
+
+        for (int i = BoardN<N>::WORDS - 1; i >= 0; i--) {
+            if (image.words[i] == best.words[i]) continue;
+            if (image.words[i] < best.words[i]) {
+                best   = image;
+                best_s = s;
+            }
+            break;
+        }
+    }
+
+    if (symmetry) *symmetry = best_s;
+
+    return best;
+}
+
+#endif // !BOARD_N_H
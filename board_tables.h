@@ -0,0 +1,23 @@
+#ifndef BOARD_TABLES_H
+#define BOARD_TABLES_H
+
+#include <cstdint>
+
+/*
+ * Row transition tables shared by board.cpp and the batched kernels
+ * in board_batch.cpp. Both are filled by init_board_tables().
+ *
+ * row_move_table holds the row after a left move at [row] and after a
+ * right move at [65536 + row]. Two extra zero entries at the end keep
+ * 32-bit gathers of the last 16-bit entry inside the array.
+ *
+ * row_score_table holds the score gained by moving a row. It is the
+ * same for both directions, since equal runs merge into the same
+ * tiles whichever end they are pushed to.
+ */
+const int ROW_MOVE_TABLE_SIZE = 2 * 65536 + 2;
+
+extern uint16_t row_move_table[ROW_MOVE_TABLE_SIZE];
+extern uint32_t row_score_table[65536];
+
+#endif // !BOARD_TABLES_H
@@ -0,0 +1,240 @@
+#include "./dataset.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+const uint32_t DATASET_MAGIC   = 0x31534432; // "2DS1"
+const uint32_t DATASET_VERSION = 1;
+
+// stdio buffer of the output file.
+const size_t DATASET_IO_BUFFER = 8 << 20;
+
+struct DatasetHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t block_records;
+};
+
+uint32_t dataset_crc32(const void* data, size_t size) {
+    static const struct CrcTable {
+        uint32_t entries[256];
+
+        CrcTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+        }
+    } table;
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t crc         = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+static bool write_block(FILE* file, const DatasetBlock* block) {
+    size_t bytes       = block->count * sizeof(DatasetRecord);
+    uint32_t crc       = dataset_crc32(block->records, bytes);
+    uint32_t prefix[2] = { block->count, crc };
+
+    return fwrite(prefix, sizeof(prefix), 1, file) == 1 &&
+           fwrite(block->records, bytes, 1, file) == 1;
+}
+
+static void writer_main(DatasetWriter* writer) {
+    unique_lock<mutex> guard(writer->lock);
+
+    for (;;) {
+        writer->wake.wait(guard, [writer] {
+            return writer->stopping || !writer->full.empty();
+        });
+
+        if (writer->full.empty()) return;
+
+        DatasetBlock* block = writer->full.front();
+        writer->full.pop_front();
+
+        // After a failed write the file ends in a torn block, so later
+        // blocks are dropped rather than written after it.
+        bool skip = writer->failed;
+
+        // Checksums and disk writes run unlocked, appenders keep
+        // filling the current block meanwhile.
+        guard.unlock();
+        bool ok = skip || write_block(writer->file, block);
+        guard.lock();
+
+        if (!ok) writer->failed = true;
+        writer->spare.push_back(block);
+        writer->room.notify_all();
+    }
+}
+
+bool init_dataset_writer(DatasetWriter* writer, const char* path) {
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+
+    writer->buffer.resize(DATASET_IO_BUFFER);
+    setvbuf(writer->file,
+            writer->buffer.data(),
+            _IOFBF,
+            writer->buffer.size());
+
+    DatasetHeader header = { DATASET_MAGIC,
+                             DATASET_VERSION,
+                             (uint32_t)sizeof(DatasetRecord),
+                             (uint32_t)DATASET_BLOCK_RECORDS };
+
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        fclose(writer->file);
+        return false;
+    }
+
+    writer->current        = new DatasetBlock;
+    writer->current->count = 0;
+    writer->stopping       = false;
+    writer->failed         = false;
+    writer->records        = 0;
+    writer->blocks         = 0;
+
+    writer->worker = thread(writer_main, writer);
+
+    return true;
+}
+
+/*
+ * Queues the current block and takes a fresh one. Called with the
+ * lock held, waits while the queue is full.
+ */
+static void queue_current(DatasetWriter* writer,
+                          unique_lock<mutex>& guard) {
+    writer->room.wait(guard, [writer] {
+        return writer->full.size() < (size_t)DATASET_QUEUE_BLOCKS;
+    });
+
+    writer->full.push_back(writer->current);
+    writer->blocks++;
+    writer->wake.notify_one();
+
+    if (writer->spare.empty()) {
+        writer->current = new DatasetBlock;
+    } else {
+        writer->current = writer->spare.back();
+        writer->spare.pop_back();
+    }
+    writer->current->count = 0;
+}
+
+void dataset_append(DatasetWriter* writer,
+                    const DatasetRecord* records,
+                    size_t count) {
+    unique_lock<mutex> guard(writer->lock);
+
+    while (count > 0) {
+        DatasetBlock* block = writer->current;
+        size_t space        = DATASET_BLOCK_RECORDS - block->count;
+        size_t n            = min(count, space);
+
+        memcpy(block->records + block->count,
+               records,
+               n * sizeof(DatasetRecord));
+        block->count    += (uint32_t)n;
+        writer->records += n;
+        records         += n;
+        count           -= n;
+
+        if (block->count == DATASET_BLOCK_RECORDS) {
+            queue_current(writer, guard);
+        }
+    }
+}
+
+bool destroy_dataset_writer(DatasetWriter* writer) {
+    {
+        unique_lock<mutex> guard(writer->lock);
+
+        if (writer->current->count > 0) queue_current(writer, guard);
+        writer->stopping = true;
+    }
+    writer->wake.notify_one();
+    writer->worker.join();
+
+    bool ok = !writer->failed;
+
+    if (fclose(writer->file) != 0) ok = false;
+
+    delete writer->current;
+    for (DatasetBlock* block : writer->spare) delete block;
+    writer->spare.clear();
+    writer->buffer.clear();
+    writer->buffer.shrink_to_fit();
+
+    return ok;
+}
+
+bool dataset_verify(const char* path, DatasetStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    DatasetHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              header.magic == DATASET_MAGIC &&
+              header.version == DATASET_VERSION &&
+              header.record_size == sizeof(DatasetRecord) &&
+              header.block_records == DATASET_BLOCK_RECORDS;
+
+    vector<DatasetRecord> records(DATASET_BLOCK_RECORDS);
+    vector<bool> seen;
+    uint32_t prefix[2];
+
+    while (ok) {
+        size_t got = fread(prefix, 1, sizeof(prefix), file);
+
+        if (got == 0) break;
+
+        uint32_t count = prefix[0];
+
+        if (got != sizeof(prefix) || count == 0 ||
+            count > (uint32_t)DATASET_BLOCK_RECORDS ||
+            fread(records.data(), sizeof(DatasetRecord), count, file) !=
+                count) {
+            ok = false;
+            break;
+        }
+
+        stats->blocks++;
+        stats->records += count;
+
+        if (dataset_crc32(records.data(),
+                          count * sizeof(DatasetRecord)) != prefix[1]) {
+            stats->bad_blocks++;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t game = records[i].game;
+
+            if (game >= seen.size()) seen.resize(game + 1, false);
+            if (!seen[game]) stats->games++;
+            seen[game] = true;
+        }
+    }
+
+    fclose(file);
+
+    return ok && stats->bad_blocks == 0;
+}
@@ -0,0 +1,104 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "board.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * One position of a self-played game, 24 bytes on disk in host
+ * (little endian) order.
+ */
+struct DatasetRecord {
+    Board board;          // before the move.
+    float value;          // search value of the chosen move.
+    uint32_t final_score; // score of the game at its end.
+    uint32_t game;        // game index, games may arrive in any order.
+    uint16_t ply;         // move number within the game.
+    uint8_t move;         // Direction played.
+    uint8_t reserved;
+};
+
+static_assert(sizeof(DatasetRecord) == 24, "records are 24 bytes");
+
+// Records per block, every block carries its own checksum.
+const int DATASET_BLOCK_RECORDS = 4096;
+
+struct DatasetBlock {
+    uint32_t count;
+    DatasetRecord records[DATASET_BLOCK_RECORDS];
+};
+
+/*
+ * Appends records to a file from any number of threads.
+ *
+ * Records are gathered into blocks under a short lock. Full blocks go
+ * to a writer thread that checksums and writes them through a large
+ * stdio buffer, so callers never wait on the disk unless it falls
+ * more than DATASET_QUEUE_BLOCKS behind.
+ *
+ * The file is a 16-byte header, then blocks of a 4-byte record count,
+ * the CRC-32 of the records and the records. Only the last block may
+ * be short.
+ */
+struct DatasetWriter {
+    FILE* file;
+    std::vector<char> buffer; // stdio buffer of file.
+    std::thread worker;
+
+    // Guards everything below; wake signals the writer, room signals
+    // appenders that a queued block was written.
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable room;
+    DatasetBlock* current;
+    std::deque<DatasetBlock*> full;
+    std::vector<DatasetBlock*> spare;
+    bool stopping;
+    bool failed; // a write failed, later blocks are dropped.
+    uint64_t records;
+    uint64_t blocks;
+};
+
+// Full blocks queued before appenders block.
+const int DATASET_QUEUE_BLOCKS = 16;
+
+bool init_dataset_writer(DatasetWriter* writer, const char* path);
+
+/*
+ * Flushes the last block, joins the writer and closes the file.
+ * Returns false when any write failed.
+ */
+bool destroy_dataset_writer(DatasetWriter* writer);
+
+void dataset_append(DatasetWriter* writer,
+                    const DatasetRecord* records,
+                    size_t count);
+
+struct DatasetStats {
+    uint64_t records;
+    uint64_t blocks;
+    uint64_t games;      // distinct game indices.
+    uint64_t bad_blocks; // checksum mismatches.
+};
+
+/*
+ * Reads every block of a dataset and checks its checksum. Returns
+ * false when the file is not a dataset, is truncated or has a bad
+ * block.
+ */
+bool dataset_verify(const char* path, DatasetStats* stats);
+
+/*
+ * Standard CRC-32 (the zlib and PNG one) of size bytes.
+ */
+uint32_t dataset_crc32(const void* data, size_t size);
+
+#endif // !DATASET_H
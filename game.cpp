@@ -141,12 +141,9 @@ GameError init_game(Game* game,
 
 
 void unload_textures(Game* game) {
-    for (const auto& p : game->textures) {
-        glDeleteTextures(1, &p.second);
-        SDL_Log("Unloaded texture \'%s\' with ID %d.\n",
-                p.first.c_str(),
-                p.second);
-    }
+    SDL_Log("Unloaded texture atlas with ID %d.\n", game->atlas.texture);
+
+    destroy_texture_atlas(&game->atlas);
 }
 
 void quit_game(Game* game) {
@@ -214,50 +211,6 @@ GameError load_textures(Game* game) {
     }
 
 
-    for (int i = 0; i < files_tags.size(); i++) {
-        GLuint texi;
-        glGenTextures(1, &texi);
-        glBindTexture(GL_TEXTURE_2D, texi);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        int width, height, nr_channels;
-        // stbi_set_flip_vertically_on_load(true);
-
-        unsigned char* data =
-            stbi_load(files_tags[i].first.c_str(), &width, &height, &nr_channels, 0);
-
-        SDL_Log("Image[%i] \'%s\' stats: width: %d, "
-                "height: %d, "
-                "nr of channels: %d, OpenGL handle: %d\n",
-                i,
-                files_tags[i].second,
-                width,
-                height,
-                nr_channels,
-                texi);
-
-        if (data) {
-            // Allocate space for texture texi on the GPU.
-            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
-
-            // Copy application data to the GPU.
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-            game->textures.insert({ files_tags[i].second, texi });
-
-        } else {
-            SDL_Log("Failed to load texture...");
-        }
-
-        glBindTexture(GL_TEXTURE_2D, 0);
-        stbi_image_free(data);
-    }
-
-    return GAME_ERROR_NO_ERROR;
+    // One texture for all of them, so tiles of any value share a draw.
+    return build_texture_atlas(&game->atlas, files_tags);
 }
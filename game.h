@@ -1,6 +1,7 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include "atlas.h"
 #include "state.h"
 #include "utils.h"
 
@@ -15,6 +16,8 @@
 #include <unordered_map>
 
 
+struct HintService;
+
 void opengl_debug_callback(GLenum source,
                            GLenum type,
                            GLuint id,
@@ -29,9 +32,10 @@ struct Game {
     SDL_GLContext gl_context;
     bool running;
     std::filesystem::path assets_dir;
-    std::unordered_map<std::string, GLuint> textures;
+    TextureAtlas atlas; // every image, see load_textures.
     Mix_Music* music;
     std::stack<State> states;
+    HintService* hints; // background AI hints, see hint.h.
 };
 
 GameError init_game(Game* game,
@@ -15,22 +15,31 @@ void init_grid(Grid* grid,
     grid->mx         = mx;
     grid->my         = my;
 
-    grid->cells.reserve(grid->grid_sz * grid->grid_sz);
+    grid->cells.resize(grid->grid_sz * grid->grid_sz);
 
     for (int row = 0; row < grid->grid_sz; row++) {
         for (int col = 0; col < grid->grid_sz; col++) {
-            grid->cells[row * 4 + col] = { 0,
-                                           { 0.0f, 0.0f },
-                                           { 0.0f, 0.0f },
-                                           { (float)cell_sz, (float)cell_sz },
-                                           0.0f };
+            Cell* cell = &grid->cells[row * grid->grid_sz + col];
 
-            grid->cells[row * 4 + col].position.x =
-                grid->position.x + mx +
-                col * (grid->cell_sz + grid->gutter);
-            grid->cells[row * 4 + col].position.y =
-                grid->position.y + my +
-                col * (grid->cell_sz + grid->gutter);
+            *cell = { 0,
+                      { 0.0f, 0.0f },
+                      { 0.0f, 0.0f },
+                      { (float)cell_sz, (float)cell_sz },
+                      0.0f };
+
+            cell->position.x = grid->position.x + mx +
+                               col * (grid->cell_sz + grid->gutter);
+            cell->position.y = grid->position.y + my +
+                               row * (grid->cell_sz + grid->gutter);
+        }
+    }
+}
+
+void grid_sync_board(Grid* grid, Board board) {
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            grid->cells[row * 4 + col].val =
+                board_get_tile(board, row, col);
         }
     }
 }
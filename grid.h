@@ -1,11 +1,13 @@
 #ifndef GRID_H
 #define GRID_H
 
+#include "board.h"
+#include "board_n.h"
 #include "math.h"
 #include <vector>
 
 struct Cell {
-    int val;
+    int val; // tile exponent, 0 for an empty cell.
     Vec2 position;
     Vec2 velocity;
     Vec2 size;
@@ -28,4 +30,23 @@ void init_grid(Grid* grid,
                float my,
                float cell_sz);
 
+/*
+ * Copies the tile exponents of a packed board into the grid cells.
+ * The board is the source of truth, the grid only renders it.
+ */
+void grid_sync_board(Grid* grid, Board board);
+
+/*
+ * Same for the variant sizes, grid_sz must be N.
+ */
+template <int N>
+void grid_sync_board(Grid* grid, const BoardN<N>& board) {
+    for (int row = 0; row < N; row++) {
+        for (int col = 0; col < N; col++) {
+            grid->cells[row * N + col].val =
+                board_n_get_tile(board, row, col);
+        }
+    }
+}
+
 #endif
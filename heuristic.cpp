@@ -0,0 +1,284 @@
+#include "./heuristic.h"
+#include "./thread_pool.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HEURISTIC_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+// Rows scored by one pool task.
+const int HEURISTIC_CHUNK_ROWS = 4096;
+
+struct WeightField {
+    const char* name;
+    size_t offset;
+};
+
+static const WeightField weight_fields[] = {
+    { "base", offsetof(HeuristicWeights, base) },
+    { "empty", offsetof(HeuristicWeights, empty) },
+    { "merges", offsetof(HeuristicWeights, merges) },
+    { "monotonicity", offsetof(HeuristicWeights, monotonicity) },
+    { "monotonicity_power",
+      offsetof(HeuristicWeights, monotonicity_power) },
+    { "sum", offsetof(HeuristicWeights, sum) },
+    { "sum_power", offsetof(HeuristicWeights, sum_power) },
+};
+
+void init_heuristic_weights(HeuristicWeights* weights) {
+    weights->base               = 200000.0f;
+    weights->empty              = 270.0f;
+    weights->merges             = 700.0f;
+    weights->monotonicity       = 47.0f;
+    weights->monotonicity_power = 4.0f;
+    weights->sum                = 11.0f;
+    weights->sum_power          = 3.5f;
+}
+
+bool heuristic_parse_weights(const char* spec, HeuristicWeights* weights) {
+    while (*spec) {
+        const char* eq  = strchr(spec, '=');
+        const char* end = strchr(spec, ',');
+
+        if (!end) end = spec + strlen(spec);
+        if (!eq || eq > end) return false;
+
+        const WeightField* field = NULL;
+
+        for (const WeightField& f : weight_fields) {
+            if (strlen(f.name) == (size_t)(eq - spec) &&
+                strncmp(f.name, spec, eq - spec) == 0) {
+                field = &f;
+            }
+        }
+        if (!field) return false;
+
+        char* value_end;
+        float value = strtof(eq + 1, &value_end);
+        if (value_end != end || value_end == eq + 1) return false;
+
+        *(float*)((char*)weights + field->offset) = value;
+
+        spec = *end ? end + 1 : end;
+    }
+
+    return true;
+}
+
+static float score_line(uint16_t row, const HeuristicWeights* w) {
+    int tiles[4];
+
+    for (int i = 0; i < 4; i++) tiles[i] = (row >> (4 * i)) & 0xF;
+
+    float sum  = 0.0f;
+    int empty  = 0;
+    int merges = 0;
+    int prev   = 0;
+    int run    = 0;
+
+    for (int i = 0; i < 4; i++) {
+        sum += powf((float)tiles[i], w->sum_power);
+
+        if (tiles[i] == 0) {
+            empty++;
+            continue;
+        }
+
+        // A run of k equal tiles is k merge candidates.
+        if (tiles[i] == prev) {
+            run++;
+        } else if (run > 0) {
+            merges += 1 + run;
+            run = 0;
+        }
+        prev = tiles[i];
+    }
+    if (run > 0) merges += 1 + run;
+
+    float left = 0.0f, right = 0.0f;
+
+    for (int i = 1; i < 4; i++) {
+        float a = powf((float)tiles[i - 1], w->monotonicity_power);
+        float b = powf((float)tiles[i], w->monotonicity_power);
+
+        if (tiles[i - 1] > tiles[i]) {
+            left += a - b;
+        } else {
+            right += b - a;
+        }
+    }
+
+    return w->base + w->empty * empty + w->merges * merges -
+           w->monotonicity * fminf(left, right) - w->sum * sum;
+}
+
+struct ScoreChunk {
+    Heuristic* heuristic;
+    int first;
+};
+
+static void score_chunk(void* arg) {
+    ScoreChunk* chunk = (ScoreChunk*)arg;
+    Heuristic* h      = chunk->heuristic;
+
+    for (int row = chunk->first;
+         row < chunk->first + HEURISTIC_CHUNK_ROWS;
+         row++) {
+        h->line_scores[row] = score_line((uint16_t)row, &h->weights);
+    }
+}
+
+void init_heuristic(Heuristic* heuristic,
+                    const HeuristicWeights* weights,
+                    ThreadPool* pool) {
+    heuristic->line_scores = new float[HEURISTIC_ROWS];
+
+    heuristic_set_weights(heuristic, weights, pool);
+}
+
+void destroy_heuristic(Heuristic* heuristic) {
+    delete[] heuristic->line_scores;
+
+    heuristic->line_scores = NULL;
+}
+
+void heuristic_set_weights(Heuristic* heuristic,
+                           const HeuristicWeights* weights,
+                           ThreadPool* pool) {
+    const int chunk_count = HEURISTIC_ROWS / HEURISTIC_CHUNK_ROWS;
+    ScoreChunk chunks[chunk_count];
+
+    heuristic->weights = *weights;
+
+    for (int i = 0; i < chunk_count; i++) {
+        chunks[i].heuristic = heuristic;
+        chunks[i].first     = i * HEURISTIC_CHUNK_ROWS;
+    }
+
+    if (pool) {
+        TaskGroup group;
+
+        for (ScoreChunk& chunk : chunks) {
+            thread_pool_submit(pool, &group, &score_chunk, &chunk);
+        }
+        thread_pool_wait(pool, &group);
+    } else {
+        for (ScoreChunk& chunk : chunks) score_chunk(&chunk);
+    }
+}
+
+float heuristic_evaluate(const Heuristic* heuristic, Board board) {
+    const float* scores = heuristic->line_scores;
+    Board t             = board_transpose(board);
+
+    // Summed in the order of the AVX2 batch lanes: the low half of
+    // the board and of its transpose, then the high halves.
+    float low = (scores[board & 0xFFFF] + scores[(board >> 16) & 0xFFFF]) +
+                (scores[t & 0xFFFF] + scores[(t >> 16) & 0xFFFF]);
+    float high =
+        (scores[(board >> 32) & 0xFFFF] + scores[board >> 48]) +
+        (scores[(t >> 32) & 0xFFFF] + scores[t >> 48]);
+
+    return low + high;
+}
+
+#ifdef HEURISTIC_X86
+
+/*
+ * Four boards per iteration. Each board is two 32-bit lanes holding
+ * two rows each, so one gather of the low 16 bits and one of the high
+ * 16 bits score all of their rows.
+ */
+TARGET_AVX2 static size_t evaluate_batch_avx2(const Heuristic* heuristic,
+                                              const Board* boards,
+                                              float* values,
+                                              size_t count) {
+    const float* scores  = heuristic->line_scores;
+    const __m256i low16  = _mm256_set1_epi32(0xFFFF);
+    const __m256i gather = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    size_t i             = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        Board t[4] = { board_transpose(boards[i]),
+                       board_transpose(boards[i + 1]),
+                       board_transpose(boards[i + 2]),
+                       board_transpose(boards[i + 3]) };
+
+        __m256i b  = _mm256_loadu_si256((const __m256i*)(boards + i));
+        __m256i bt = _mm256_loadu_si256((const __m256i*)t);
+
+        __m256 rows = _mm256_add_ps(
+            _mm256_i32gather_ps(scores, _mm256_and_si256(b, low16), 4),
+            _mm256_i32gather_ps(scores, _mm256_srli_epi32(b, 16), 4));
+        __m256 cols = _mm256_add_ps(
+            _mm256_i32gather_ps(scores, _mm256_and_si256(bt, low16), 4),
+            _mm256_i32gather_ps(scores, _mm256_srli_epi32(bt, 16), 4));
+
+        // Lanes 2k and 2k+1 are the low and high halves of board k.
+        __m256 halves = _mm256_add_ps(rows, cols);
+        __m256 sums   = _mm256_hadd_ps(halves, halves);
+
+        _mm_storeu_ps(values + i,
+                      _mm256_castps256_ps128(
+                          _mm256_permutevar8x32_ps(sums, gather)));
+    }
+
+    return i;
+}
+
+#endif // HEURISTIC_X86
+
+void heuristic_evaluate_batch(const Heuristic* heuristic,
+                              const Board* boards,
+                              float* values,
+                              size_t count) {
+    size_t done = 0;
+
+#ifdef HEURISTIC_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+
+    if (avx2) done = evaluate_batch_avx2(heuristic, boards, values, count);
+#endif
+
+    for (size_t i = done; i < count; i++) {
+        values[i] = heuristic_evaluate(heuristic, boards[i]);
+    }
+}
+
+static const Heuristic* default_heuristic() {
+    static Heuristic heuristic;
+    static bool ready = [] {
+        HeuristicWeights weights;
+        init_heuristic_weights(&weights);
+        init_heuristic(&heuristic, &weights, NULL);
+        return true;
+    }();
+
+    (void)ready;
+    return &heuristic;
+}
+
+float evaluate_heuristic(Board board, const void* ctx) {
+    const Heuristic* heuristic =
+        ctx ? (const Heuristic*)ctx : default_heuristic();
+
+    return heuristic_evaluate(heuristic, board);
+}
+
+void evaluate_heuristic_batch(const Board* boards,
+                              float* values,
+                              size_t count,
+                              const void* ctx) {
+    const Heuristic* heuristic =
+        ctx ? (const Heuristic*)ctx : default_heuristic();
+
+    heuristic_evaluate_batch(heuristic, boards, values, count);
+}
@@ -0,0 +1,93 @@
+#ifndef HEURISTIC_H
+#define HEURISTIC_H
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct ThreadPool;
+
+const int HEURISTIC_ROWS = 65536;
+
+/*
+ * Terms of the per-line score. Every row and every column of a board
+ * is scored on its own and the eight scores are summed.
+ */
+struct HeuristicWeights {
+    float base;               // constant per line, keeps values positive.
+    float empty;              // per empty cell.
+    float merges;             // per tile that can merge along the line.
+    float monotonicity;       // penalty for tiles out of order.
+    float monotonicity_power;
+    float sum;                // penalty on the sum of tile^sum_power.
+    float sum_power;
+};
+
+/*
+ * Line scores for every possible 16-bit row, indexed by the row.
+ * Columns share the table through the board transpose.
+ */
+struct Heuristic {
+    HeuristicWeights weights;
+    float* line_scores;
+};
+
+/*
+ * Fills weights with values tuned for 4x4 expectimax play.
+ */
+void init_heuristic_weights(HeuristicWeights* weights);
+
+/*
+ * Parses a comma separated list of name=value pairs over weights,
+ * e.g. "empty=270,merges=700". Names are the HeuristicWeights fields.
+ * Returns false on an unknown name or a malformed value.
+ */
+bool heuristic_parse_weights(const char* spec, HeuristicWeights* weights);
+
+/*
+ * Allocates and fills the tables. pool may be NULL.
+ */
+void init_heuristic(Heuristic* heuristic,
+                    const HeuristicWeights* weights,
+                    ThreadPool* pool);
+
+void destroy_heuristic(Heuristic* heuristic);
+
+/*
+ * Rescores every row with new weights. Chunks of rows are spread
+ * over the pool when one is given.
+ */
+void heuristic_set_weights(Heuristic* heuristic,
+                           const HeuristicWeights* weights,
+                           ThreadPool* pool);
+
+/*
+ * Eight table loads: four rows, then four rows of the transpose.
+ */
+float heuristic_evaluate(const Heuristic* heuristic, Board board);
+
+/*
+ * heuristic_evaluate of count boards. With AVX2, four boards go
+ * through each iteration and their 32 line scores are gathered eight
+ * at a time; the sums come out bit for bit the same.
+ */
+void heuristic_evaluate_batch(const Heuristic* heuristic,
+                              const Board* boards,
+                              float* values,
+                              size_t count);
+
+/*
+ * Evaluator adapter, ctx is the Heuristic. A NULL ctx uses a shared
+ * heuristic with the default weights, built on first use, which is
+ * what init_search_config selects.
+ */
+float evaluate_heuristic(Board board, const void* ctx);
+
+// BatchEvaluator adapter, ctx as for evaluate_heuristic.
+void evaluate_heuristic_batch(const Board* boards,
+                              float* values,
+                              size_t count,
+                              const void* ctx);
+
+#endif // !HEURISTIC_H
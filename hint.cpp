@@ -0,0 +1,128 @@
+#include "./hint.h"
+
+using namespace std;
+
+static bool queue_push(HintQueue* queue, const HintResult& result) {
+    uint32_t tail = queue->tail.load(memory_order_relaxed);
+    uint32_t head = queue->head.load(memory_order_acquire);
+
+    if (tail - head == (uint32_t)HINT_QUEUE_SIZE) return false;
+
+    queue->slots[tail & (HINT_QUEUE_SIZE - 1)] = result;
+    queue->tail.store(tail + 1, memory_order_release);
+
+    return true;
+}
+
+static bool queue_pop(HintQueue* queue, HintResult* result) {
+    uint32_t head = queue->head.load(memory_order_relaxed);
+    uint32_t tail = queue->tail.load(memory_order_acquire);
+
+    if (head == tail) return false;
+
+    *result = queue->slots[head & (HINT_QUEUE_SIZE - 1)];
+    queue->head.store(head + 1, memory_order_release);
+
+    return true;
+}
+
+static void worker_main(HintService* service) {
+    for (;;) {
+        Board board;
+        uint64_t generation;
+
+        {
+            unique_lock<mutex> guard(service->lock);
+
+            service->wake.wait(guard, [service] {
+                return service->stopping ||
+                       service->generation.load() != service->requested;
+            });
+
+            if (service->stopping) return;
+
+            board              = service->request;
+            generation         = service->generation.load();
+            service->requested = generation;
+
+            // Reset under the lock hint_post and destroy cancel under,
+            // so a cancel is never wiped by a reset that follows it.
+            init_search_control(&service->control);
+        }
+
+        SearchResult search;
+        ai_search(board, &service->config, &search);
+
+        if (service->generation.load() != generation) continue;
+
+        HintResult result;
+
+        result.generation = generation;
+        result.board      = board;
+        result.best       = search.best;
+        result.value      = search.value;
+        result.depth      = search.depth;
+        result.elapsed_us = search.elapsed_us;
+
+        // A full queue means the reader stopped draining; the result
+        // is lost, like any other stale one.
+        queue_push(&service->results, result);
+    }
+}
+
+void init_hint_service(HintService* service, const SearchConfig* config) {
+    service->config         = *config;
+    service->config.control = &service->control;
+    service->request        = 0;
+    service->requested      = 0;
+    service->stopping       = false;
+
+    service->generation.store(0);
+    service->results.head.store(0);
+    service->results.tail.store(0);
+    init_search_control(&service->control);
+
+    service->worker = thread(worker_main, service);
+}
+
+void destroy_hint_service(HintService* service) {
+    {
+        lock_guard<mutex> guard(service->lock);
+        service->stopping = true;
+        search_control_cancel(&service->control);
+    }
+    service->wake.notify_one();
+    service->worker.join();
+}
+
+uint64_t hint_post(HintService* service, Board board) {
+    uint64_t generation;
+
+    {
+        lock_guard<mutex> guard(service->lock);
+
+        service->request = board;
+        generation       = service->generation.load() + 1;
+        service->generation.store(generation);
+        search_control_cancel(&service->control);
+    }
+
+    service->wake.notify_one();
+
+    return generation;
+}
+
+bool hint_poll(HintService* service, HintResult* result) {
+    uint64_t latest = service->generation.load();
+    HintResult popped;
+    bool found = false;
+
+    while (queue_pop(&service->results, &popped)) {
+        if (popped.generation != latest) continue;
+
+        *result = popped;
+        found   = true;
+    }
+
+    return found;
+}
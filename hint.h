@@ -0,0 +1,86 @@
+#ifndef HINT_H
+#define HINT_H
+
+#include "ai.h"
+#include "board.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Results the worker may get ahead of the reader by, a power of two.
+const int HINT_QUEUE_SIZE = 8;
+
+struct HintResult {
+    uint64_t generation; // of the hint_post that asked for it.
+    Board board;
+    Direction best;      // DIR_COUNT when no move is legal.
+    float value;
+    int depth;
+    uint64_t elapsed_us;
+};
+
+/*
+ * Single-producer single-consumer ring of results. The worker only
+ * writes tail and the reader only writes head, so neither side ever
+ * takes a lock or waits on the other.
+ */
+struct HintQueue {
+    HintResult slots[HINT_QUEUE_SIZE];
+    std::atomic<uint32_t> head; // next slot to read.
+    std::atomic<uint32_t> tail; // next slot to write.
+};
+
+/*
+ * Searches posted boards on a thread of its own, so the thread that
+ * renders and handles input never runs a search.
+ *
+ * Only the latest posted board matters. Posting a new one cancels
+ * the search in progress through its SearchControl, and results for
+ * older boards are dropped on both sides of the queue.
+ */
+struct HintService {
+    SearchConfig config;
+    SearchControl control;
+    std::thread worker;
+
+    // Guards the request, stopping and resetting or cancelling
+    // control; wake signals a change.
+    std::mutex lock;
+    std::condition_variable wake;
+    Board request;
+    uint64_t requested; // generation the worker has taken.
+    bool stopping;
+
+    std::atomic<uint64_t> generation; // latest posted.
+    HintQueue results;
+};
+
+/*
+ * Starts the worker. config is copied, its control is replaced by the
+ * service's own. An iterative search with a budget suits it best: a
+ * new board waits at most for the budget of the one it replaces.
+ */
+void init_hint_service(HintService* service, const SearchConfig* config);
+
+/*
+ * Cancels any search in progress and joins the worker.
+ */
+void destroy_hint_service(HintService* service);
+
+/*
+ * Asks for a hint on board, replacing any earlier request. Returns
+ * the generation its result will carry. Never blocks on the search.
+ */
+uint64_t hint_post(HintService* service, Board board);
+
+/*
+ * Takes the result for the latest posted board if it has arrived.
+ * Results for older boards are discarded. Never blocks; meant to be
+ * drained once per frame by the thread that posts.
+ */
+bool hint_poll(HintService* service, HintResult* result);
+
+#endif // !HINT_H
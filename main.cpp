@@ -10,6 +10,7 @@
 #include <SDL_surface.h>
 #include <SDL_timer.h>
 #include <SDL_video.h>
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
@@ -27,6 +28,7 @@
 #include "anim.h"
 #include "game.h"
 #include "grid.h"
+#include "hint.h"
 #include "math.h"
 #include "renderer.h"
 #include "state.h"
@@ -125,6 +127,8 @@ int main(int argc, char* argv[]) {
     }
 
 
+    init_board_tables();
+
     Game game;
 
     GameError err =
@@ -142,7 +146,19 @@ int main(int argc, char* argv[]) {
         return err;
     }
 
-    if (glIsTexture(game.textures.at("bg")) != GL_TRUE) {
+    // Hints search on their own thread, so a deep search never holds
+    // up input or SDL_GL_SwapWindow.
+    SearchConfig hint_config;
+    init_search_config(&hint_config);
+    hint_config.max_depth = 8;
+    hint_config.budget_us = 200000;
+    hint_config.iterative = true;
+
+    HintService hints;
+    init_hint_service(&hints, &hint_config);
+    game.hints = &hints;
+
+    if (glIsTexture(game.atlas.texture) != GL_TRUE) {
         SDL_Log("Something has happned here...\n");
     }
     //
@@ -150,37 +166,24 @@ int main(int argc, char* argv[]) {
     //
 
     Renderer renderer;
-    init_renderer(&renderer);
-
-    // create and use sprite shader...
-    //
-
-
-    GLuint sprite_shader;
-    err = create_shader_program(game.assets_dir / "shaders" / "sprite.vs.glsl",
-                                game.assets_dir / "shaders" / "sprite.fs.glsl",
-                                &sprite_shader);
+    err = init_renderer(&renderer);
 
     if (err != 0) {
-        SDL_Log("Failed to create sprite shader.\n");
+        destroy_hint_service(&hints);
         quit_game(&game);
         return err;
     }
 
-    GLuint blink_shader;
-    err = create_shader_program(game.assets_dir / "shaders" / "blink.vs.glsl",
-                                game.assets_dir / "shaders" / "blink.fs.glsl",
-                                &blink_shader);
+    err = create_shader_program(game.assets_dir / "shaders" / "batch.vs.glsl",
+                                game.assets_dir / "shaders" / "batch.fs.glsl",
+                                &renderer.shaders[SHADER_BATCH]);
     if (err != 0) {
-        SDL_Log(
-            "Failed to create blink shader program\n");
+        SDL_Log("Failed to create batch shader program\n");
+        destroy_hint_service(&hints);
         quit_game(&game);
         return err;
     }
 
-    add_shader(&renderer, std::make_pair("blink", blink_shader));
-    add_shader(&renderer, std::make_pair("sprite", sprite_shader));
-
 
     glDisable(GL_DEPTH_TEST);
     glClearColor(0.5, 0.0, 0.0, 0.0);
@@ -197,22 +200,19 @@ int main(int argc, char* argv[]) {
                  0.0f,
                  100.0f);
 
-    print_mat4x4("Projection Matrix - Sprite", projection_matrix);
+    print_mat4x4("Projection Matrix - Batch", projection_matrix);
 
 
-    glUseProgram(renderer.shaders["sprite"]);
+    // The batch shader gets its transform per instance, only the
+    // projection is uniform.
+    const Shader& batch = renderer.shaders[SHADER_BATCH];
 
-    glUniformMatrix4fv(glGetUniformLocation(renderer.shaders["sprite"],
-                                            "projection"),
-                       1,
-                       GL_TRUE,
-                       projection_matrix[0]);
-    glUniform1i(
-        glGetUniformLocation(renderer.shaders["sprite"], "image"), 0);
+    set_uniform(batch.program, batch.projection, projection_matrix);
+    set_uniform(batch.program, batch.image, 0);
 
 
     IntroState intro;
-    intro_state_init(&intro, &game, &renderer);
+    intro_state_init(&intro);
     State state = { .intro = intro };
 
     game.states.push(state);
@@ -268,11 +268,20 @@ int main(int argc, char* argv[]) {
                 case INTRO_STATE:
                     intro_state_handle_input(&game, &event);
                     break;
-                case GAMEPLAY_STATE: break;
+                case GAMEPLAY_STATE:
+                    game_play_state_handle_input(
+                        &game.states.top().game_play, &game, &event);
+                    break;
                 default: break;
             }
         }
 
+        // Takes whatever hint has arrived, never waits for one.
+        if (game.states.top().state_id == GAMEPLAY_STATE) {
+            game_play_state_poll_hints(&game.states.top().game_play,
+                                       &game);
+        }
+
         while (lag_time >= UPDATE_RATE) {
             // update(dt, &grid.cells[0], &grid);
             switch (game.states.top().state_id) {
@@ -292,23 +301,35 @@ int main(int argc, char* argv[]) {
                 intro_state_render(&game.states.top().intro, &game, &renderer);
                 break;
             case GAMEPLAY_STATE:
-                render_sprite(&game,
-                              "bg",
-                              &renderer,
-                              "sprite",
-                              { 0, 0 },
-                              { (float)game.win_width,
-                                (float)game.win_height },
-                              0,
-                              { 2, 2, 2 });
-                render_sprite(&game,
-                              "2048",
-                              &renderer,
-                              "sprite",
-                              grid.cells[0].position,
-                              grid.cells[0].size,
-                              0,
-                              { 0, 0, 0 });
+                // Background and tiles share the atlas, so one instanced draw.
+                queue_sprite(&game,
+                             "bg",
+                             &renderer,
+                             SHADER_BATCH,
+                             LAYER_BACKGROUND,
+                             { 0, 0 },
+                             { (float)game.win_width,
+                               (float)game.win_height },
+                             0,
+                             { 1, 1, 1, 1 });
+
+                grid_sync_board(&grid, game.states.top().game_play.board);
+
+                for (const Cell& cell : grid.cells) {
+                    // Tile images stop at 2048.
+                    if (cell.val == 0) continue;
+
+                    queue_tile(&game,
+                               min(cell.val, ATLAS_TILE_COUNT - 1),
+                               &renderer,
+                               SHADER_BATCH,
+                               LAYER_BOARD,
+                               cell.position,
+                               cell.size,
+                               { 1, 1, 1, 1 });
+                }
+
+                flush_sprites(&renderer);
                 break;
 
             default: break;
@@ -319,6 +340,9 @@ int main(int argc, char* argv[]) {
         prev_time = current_time;
     }
 
+    destroy_sprite_batch(&renderer.sprites);
+    for (Shader& shader : renderer.shaders) destroy_shader(&shader);
+    destroy_hint_service(&hints);
     quit_game(&game);
 
     return 0;
@@ -1,5 +1,32 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include "ai.h"
+#include "board.h"
+#include "board_batch.h"
+#include "board_n.h"
+#include "dataset.h"
+#include "heuristic.h"
+#include "hint.h"
+#include "montecarlo.h"
+#include "ntuple.h"
+#include "ntuple_quant.h"
+#include "rng.h"
+#include "server.h"
+#include "symmetry.h"
+#include "tablebase.h"
+#include "thread_pool.h"
+#include "ttable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
 static unsigned long factorial(unsigned int number) {
     return number <= 1 ? 1 : factorial(number - 1);
 }
@@ -7,3 +34,1183 @@ static unsigned long factorial(unsigned int number) {
 TEST_CASE("Factorials are computed", "[factorial]") {
     REQUIRE(factorial(1) == 1);
 }
+
+
+static const bool board_tables_ready = (init_board_tables(), true);
+
+static Board board_from_rows(const int rows[4][4]) {
+    Board board = 0;
+
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            board = board_set_tile(board, row, col, rows[row][col]);
+        }
+    }
+
+    return board;
+}
+
+TEST_CASE("Tiles slide and merge once per move", "[board]") {
+    const int start[4][4] = { { 1, 1, 1, 1 },
+                              { 2, 0, 2, 0 },
+                              { 0, 0, 0, 3 },
+                              { 1, 2, 3, 4 } };
+    const int left[4][4]  = { { 2, 2, 0, 0 },
+                              { 3, 0, 0, 0 },
+                              { 3, 0, 0, 0 },
+                              { 1, 2, 3, 4 } };
+    const int right[4][4] = { { 0, 0, 2, 2 },
+                              { 0, 0, 0, 3 },
+                              { 0, 0, 0, 3 },
+                              { 1, 2, 3, 4 } };
+
+    Board board    = board_from_rows(start);
+    uint32_t score = 0;
+
+    REQUIRE(board_move(board, DIR_LEFT, &score) ==
+            board_from_rows(left));
+    REQUIRE(score == 4 + 4 + 8);
+
+    REQUIRE(board_move(board, DIR_RIGHT, NULL) ==
+            board_from_rows(right));
+}
+
+TEST_CASE("Vertical moves act on columns", "[board]") {
+    const int start[4][4] = { { 1, 0, 0, 0 },
+                              { 1, 0, 2, 0 },
+                              { 0, 0, 2, 0 },
+                              { 1, 0, 1, 0 } };
+    const int up[4][4]    = { { 2, 0, 3, 0 },
+                              { 1, 0, 1, 0 },
+                              { 0, 0, 0, 0 },
+                              { 0, 0, 0, 0 } };
+    const int down[4][4]  = { { 0, 0, 0, 0 },
+                              { 0, 0, 0, 0 },
+                              { 1, 0, 3, 0 },
+                              { 2, 0, 1, 0 } };
+
+    Board board = board_from_rows(start);
+
+    REQUIRE(board_move(board, DIR_UP, NULL) == board_from_rows(up));
+    REQUIRE(board_move(board, DIR_DOWN, NULL) ==
+            board_from_rows(down));
+}
+
+TEST_CASE("Spawn fills an empty cell", "[board]") {
+    Board board = 0;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        board = board_spawn(board, i * 0x1111u);
+        REQUIRE(board_count_empty(board) == 15 - (int)i);
+    }
+
+    REQUIRE(board_spawn(board, 0) == board);
+}
+
+TEST_CASE("Game over needs a full board without merges", "[board]") {
+    const int stuck[4][4] = { { 1, 2, 1, 2 },
+                              { 2, 1, 2, 1 },
+                              { 1, 2, 1, 2 },
+                              { 2, 1, 2, 1 } };
+    Board board           = board_from_rows(stuck);
+
+    REQUIRE(board_is_game_over(board));
+    REQUIRE_FALSE(board_is_game_over(board_set_tile(board, 0, 0, 2)));
+    REQUIRE(board_max_tile(board) == 2);
+}
+
+TEST_CASE("Transpose swaps rows and columns", "[board]") {
+    Board board = 0x0123456789ABCDEFULL;
+
+    REQUIRE(board_transpose(board_transpose(board)) == board);
+
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            REQUIRE(board_get_tile(board_transpose(board), col, row) ==
+                    board_get_tile(board, row, col));
+        }
+    }
+}
+
+TEST_CASE("Batched kernels match board_move", "[board]") {
+    const size_t count = 1027;
+    std::vector<Board> boards(count), out(count);
+    std::vector<Direction> dirs(count);
+    std::vector<uint32_t> scores(count);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+    for (size_t i = 0; i < count; i++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        boards[i] = x & (x >> 3);
+        dirs[i]   = (Direction)(x % DIR_COUNT);
+    }
+
+    BatchKernel detected = board_batch_kernel();
+
+    for (int kernel = BATCH_KERNEL_SCALAR; kernel <= BATCH_KERNEL_AVX2;
+         kernel++) {
+        board_batch_set_kernel((BatchKernel)kernel);
+        board_move_batch(boards.data(),
+                         dirs.data(),
+                         out.data(),
+                         scores.data(),
+                         count);
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t score = 0;
+            REQUIRE(out[i] == board_move(boards[i], dirs[i], &score));
+            REQUIRE(scores[i] == score);
+        }
+    }
+
+    board_batch_set_kernel(detected);
+}
+
+TEST_CASE("Expectimax only returns legal moves", "[ai]") {
+    const int rows[4][4] = { { 1, 2, 3, 4 },
+                             { 2, 3, 4, 5 },
+                             { 3, 4, 5, 6 },
+                             { 4, 5, 6, 0 } };
+    Board board          = board_from_rows(rows);
+
+    SearchConfig config;
+    init_search_config(&config);
+
+    SearchResult result;
+    ai_search(board, &config, &result);
+
+    REQUIRE((result.best == DIR_DOWN || result.best == DIR_RIGHT));
+    REQUIRE(result.nodes > 0);
+    REQUIRE_FALSE(result.timed_out);
+
+    const int stuck[4][4] = { { 1, 2, 1, 2 },
+                              { 2, 1, 2, 1 },
+                              { 1, 2, 1, 2 },
+                              { 2, 1, 2, 1 } };
+    ai_search(board_from_rows(stuck), &config, &result);
+    REQUIRE(result.best == DIR_COUNT);
+}
+
+TEST_CASE("Expectimax falls back when out of time", "[ai]") {
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth       = 12;
+    config.min_probability = 0.0f;
+    config.budget_us       = 1;
+
+    SearchResult result;
+    ai_search(board_spawn(0, 0), &config, &result);
+
+    REQUIRE(result.timed_out);
+    REQUIRE(result.depth == 1);
+    REQUIRE(result.best != DIR_COUNT);
+}
+
+static float evaluate_minus_one(Board, const void*) {
+    return -1.0f;
+}
+
+TEST_CASE("Afterstate searches add merge rewards", "[ai]") {
+    const int rows[4][4] = { { 5, 5, 0, 0 },
+                             { 0, 0, 0, 0 },
+                             { 0, 0, 0, 0 },
+                             { 0, 0, 0, 0 } };
+    Board board          = board_from_rows(rows);
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.eval      = { &evaluate_minus_one, NULL };
+    config.max_depth = 1;
+
+    SearchResult result;
+    ai_search(board, &config, &result);
+    REQUIRE(result.value == -1.0f);
+
+    config.add_rewards = true;
+    ai_search(board, &config, &result);
+    REQUIRE((result.best == DIR_LEFT || result.best == DIR_RIGHT));
+    REQUIRE(result.value == 63.0f);
+
+    // Deeper player moves keep negative values instead of clamping.
+    config.add_rewards = false;
+    config.max_depth   = 2;
+    ai_search(board, &config, &result);
+    REQUIRE(result.value == -1.0f);
+}
+
+TEST_CASE("Parallel expectimax matches the serial search", "[ai]") {
+    const int rows[4][4] = { { 1, 0, 0, 2 },
+                             { 3, 0, 1, 0 },
+                             { 0, 4, 0, 0 },
+                             { 1, 0, 0, 0 } };
+    Board board          = board_from_rows(rows);
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth = 3;
+
+    SearchResult serial;
+    ai_search(board, &config, &serial);
+
+    for (int threads = 1; threads <= 4; threads += 3) {
+        ThreadPool pool;
+        init_thread_pool(&pool, threads);
+
+        for (int split = 0; split <= 2; split++) {
+            config.pool        = &pool;
+            config.split_plies = split;
+
+            SearchResult parallel;
+            ai_search(board, &config, &parallel);
+
+            REQUIRE(parallel.best == serial.best);
+            REQUIRE(parallel.value == serial.value);
+            REQUIRE(parallel.nodes == serial.nodes);
+        }
+
+        destroy_thread_pool(&pool);
+    }
+}
+
+struct NestedTask {
+    ThreadPool* pool;
+    std::atomic<int>* leaves;
+    int pending_after_wait;
+};
+
+static void count_leaf(void* arg) {
+    ((std::atomic<int>*)arg)->fetch_add(1);
+}
+
+static void run_nested(void* arg) {
+    NestedTask* task = (NestedTask*)arg;
+    TaskGroup group;
+
+    for (int i = 0; i < 8; i++) {
+        thread_pool_submit(task->pool, &group, count_leaf, task->leaves);
+    }
+    thread_pool_wait(task->pool, &group);
+
+    // Every leaf of the group ran before the wait returned.
+    task->pending_after_wait = group.pending.load();
+}
+
+TEST_CASE("Thread pool waits cover nested groups", "[thread_pool]") {
+    ThreadPool pool;
+    init_thread_pool(&pool, 3);
+
+    for (int round = 0; round < 50; round++) {
+        std::atomic<int> leaves{ 0 };
+        NestedTask tasks[16];
+        TaskGroup group;
+
+        for (NestedTask& task : tasks) {
+            task = { &pool, &leaves, -1 };
+            thread_pool_submit(&pool, &group, run_nested, &task);
+        }
+        thread_pool_wait(&pool, &group);
+
+        REQUIRE(leaves.load() == 16 * 8);
+        REQUIRE(pool.queued.load() == 0);
+        for (const NestedTask& task : tasks) {
+            REQUIRE(task.pending_after_wait == 0);
+        }
+    }
+
+    destroy_thread_pool(&pool);
+}
+
+TEST_CASE("Transposition table keeps the deepest entry", "[ttable]") {
+    TransTable table;
+    init_trans_table(&table, 1);
+
+    float value = 0.0f;
+    REQUIRE_FALSE(tt_probe(&table, 0x1234, 1, &value));
+
+    tt_store(&table, 0x1234, 3, 42.0f);
+    REQUIRE(tt_probe(&table, 0x1234, 3, &value));
+    REQUIRE(value == 42.0f);
+    REQUIRE_FALSE(tt_probe(&table, 0x1234, 4, &value));
+
+    // A shallower result must not replace a deeper one.
+    tt_store(&table, 0x1234, 2, 7.0f);
+    REQUIRE(tt_probe(&table, 0x1234, 1, &value));
+    REQUIRE(value == 42.0f);
+
+    for (Board board = 1; board <= 20000; board++) {
+        tt_store(&table, board << 20, 1, 1.0f);
+    }
+
+    TTStats stats;
+    tt_get_stats(&table, &stats);
+    REQUIRE(stats.occupancy > 0.1);
+    REQUIRE(stats.current_occupancy == stats.occupancy);
+
+    // Old entries are still found, but no longer count as current.
+    tt_new_search(&table);
+    REQUIRE(tt_probe(&table, 0x1234, 3, &value));
+
+    tt_get_stats(&table, &stats);
+    REQUIRE(stats.current_occupancy == 0.0);
+
+    destroy_trans_table(&table);
+}
+
+TEST_CASE("Expectimax reuses transposition table entries", "[ai]") {
+    TransTable table;
+    init_trans_table(&table, 4);
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.tt = &table;
+
+    SearchResult result;
+    ai_search(board_spawn(board_spawn(0, 1), 0x8000), &config, &result);
+
+    REQUIRE(result.best != DIR_COUNT);
+    REQUIRE(result.tt_hits > 0);
+
+    TTStats stats;
+    tt_get_stats(&table, &stats);
+    REQUIRE(stats.probes == result.tt_probes);
+    REQUIRE(stats.hit_rate > 0.0);
+
+    destroy_trans_table(&table);
+}
+
+TEST_CASE("Monte Carlo results do not depend on threads", "[mc]") {
+    const int rows[4][4] = { { 1, 1, 0, 0 },
+                             { 0, 2, 0, 0 },
+                             { 0, 0, 0, 0 },
+                             { 0, 0, 0, 1 } };
+    Board board          = board_from_rows(rows);
+
+    McConfig config;
+    init_mc_config(&config);
+    config.rollouts  = 150;
+    config.max_moves = 50;
+
+    McResult serial;
+    mc_search(board, &config, &serial);
+
+    REQUIRE(serial.best != DIR_COUNT);
+    REQUIRE(serial.rollouts == 4 * 150);
+
+    ThreadPool pool;
+    init_thread_pool(&pool, 3);
+    config.pool = &pool;
+
+    McResult parallel;
+    mc_search(board, &config, &parallel);
+
+    REQUIRE(parallel.best == serial.best);
+    REQUIRE(parallel.moves == serial.moves);
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        REQUIRE(parallel.value[dir] == serial.value[dir]);
+    }
+
+    destroy_thread_pool(&pool);
+}
+
+/*
+ * Cell-by-cell reference for the templated boards.
+ */
+template <int N>
+static BoardN<N> reference_move(const BoardN<N>& board,
+                                Direction dir,
+                                uint32_t* score) {
+    BoardN<N> out = {};
+
+    for (int i = 0; i < N; i++) {
+        int line[8], merged[8];
+        int n          = 0;
+        bool can_merge = false;
+
+        for (int j = 0; j < N; j++) {
+            int row = dir == DIR_LEFT || dir == DIR_RIGHT ? i :
+                dir == DIR_UP                             ? j :
+                                                            N - 1 - j;
+            int col = dir == DIR_UP || dir == DIR_DOWN ? i :
+                dir == DIR_LEFT                        ? j :
+                                                         N - 1 - j;
+            line[j] = board_n_get_tile(board, row, col);
+        }
+
+        for (int j = 0; j < N; j++) {
+            if (line[j] == 0) continue;
+            if (can_merge && merged[n - 1] == line[j] && line[j] != 15) {
+                *score += 1u << ++merged[n - 1];
+                can_merge = false;
+            } else {
+                merged[n++] = line[j];
+                can_merge   = true;
+            }
+        }
+
+        for (int j = 0; j < N; j++) {
+            int row = dir == DIR_LEFT || dir == DIR_RIGHT ? i :
+                dir == DIR_UP                             ? j :
+                                                            N - 1 - j;
+            int col = dir == DIR_UP || dir == DIR_DOWN ? i :
+                dir == DIR_LEFT                        ? j :
+                                                         N - 1 - j;
+            board_n_set_tile(&out, row, col, j < n ? merged[j] : 0);
+        }
+    }
+
+    return out;
+}
+
+template <int N>
+static void check_board_n() {
+    uint64_t x = 0x2545F4914F6CDD1DULL + N;
+
+    for (int trial = 0; trial < 2000; trial++) {
+        BoardN<N> board = {};
+
+        for (int row = 0; row < N; row++) {
+            for (int col = 0; col < N; col++) {
+                x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+                board_n_set_tile(&board, row, col, (int)(x % 5));
+            }
+        }
+
+        REQUIRE(board_n_transpose(board_n_transpose(board)) == board);
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            uint32_t score = 0, expected_score = 0;
+
+            BoardN<N> moved =
+                board_n_move(board, (Direction)dir, &score);
+
+            REQUIRE(moved == reference_move(board,
+                                            (Direction)dir,
+                                            &expected_score));
+            REQUIRE(score == expected_score);
+        }
+
+        BoardN<N> spawned = board_n_spawn(board, (uint32_t)x);
+        int empty         = board_n_count_empty(board);
+        REQUIRE(board_n_count_empty(spawned) ==
+                (empty > 0 ? empty - 1 : 0));
+    }
+}
+
+TEST_CASE("NxN boards match a cell-by-cell reference", "[board_n]") {
+    check_board_n<2>();
+    check_board_n<3>();
+    check_board_n<4>();
+    check_board_n<5>();
+    check_board_n<6>();
+    check_board_n<7>();
+    check_board_n<8>();
+}
+
+TEST_CASE("BoardN<4> is laid out like Board", "[board_n]") {
+    BoardN<4> board = { { 0x0123456789ABCDEFULL } };
+
+    REQUIRE(board_n_get_tile(board, 1, 2) ==
+            board_get_tile(board.words[0], 1, 2));
+    REQUIRE(board_n_transpose(board).words[0] ==
+            board_transpose(board.words[0]));
+}
+
+TEST_CASE("N-tuple values are symmetric and survive a checkpoint",
+          "[ntuple]") {
+    NTupleNetwork network;
+    REQUIRE(init_ntuple_network(&network, NTUPLE_PATTERNS_4X5, 5));
+
+    const int rows[4][4] = {
+        { 1, 2, 3, 0 },
+        { 0, 4, 0, 0 },
+        { 0, 0, 5, 0 },
+        { 0, 0, 0, 6 },
+    };
+    Board board = board_from_rows(rows);
+
+    ntuple_update(&network, board, 0.5f);
+
+    // Each of the 5 patterns is looked up under all 8 symmetries.
+    REQUIRE(ntuple_evaluate(&network, board) > 0.0f);
+    REQUIRE(ntuple_evaluate(&network, board_transpose(board)) ==
+            ntuple_evaluate(&network, board));
+
+    const char* path = "ntuple_test.bin";
+    REQUIRE(ntuple_save(&network, path));
+
+    NTupleNetwork loaded;
+    REQUIRE(ntuple_load(&loaded, path));
+    REQUIRE(loaded.pattern_count == network.pattern_count);
+    REQUIRE(evaluate_ntuple(board, &loaded) ==
+            ntuple_evaluate(&network, board));
+
+    remove(path);
+    destroy_ntuple_network(&loaded);
+    destroy_ntuple_network(&network);
+}
+
+TEST_CASE("TD training improves the n-tuple player", "[ntuple]") {
+    NTupleNetwork network;
+    REQUIRE(init_ntuple_network(&network, NTUPLE_PATTERNS_4X5, 5));
+
+    TrainConfig config;
+    init_train_config(&config);
+    config.games = 500;
+
+    TrainStats first, second;
+    ntuple_train(&network, &config, &first);
+    config.seed = 2;
+    ntuple_train(&network, &config, &second);
+
+    REQUIRE(first.games == 500);
+    REQUIRE(second.mean_score > first.mean_score);
+
+    destroy_ntuple_network(&network);
+}
+
+TEST_CASE("Quantized n-tuple networks track the float one", "[ntuple]") {
+    NTupleNetwork network;
+    REQUIRE(init_ntuple_network(&network, NTUPLE_PATTERNS_4X5, 5));
+
+    TrainConfig config;
+    init_train_config(&config);
+    config.games = 200;
+
+    TrainStats stats;
+    ntuple_train(&network, &config, &stats);
+
+    std::vector<Board> boards;
+    uint64_t x = 88172645463325252ULL;
+
+    for (int i = 0; i < 2000; i++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        boards.push_back(x & 0x3333333333333333ULL);
+    }
+
+    for (QuantBits bits : { QUANT_INT16, QUANT_INT8 }) {
+        QuantNetwork quant;
+        REQUIRE(init_quant_network(&quant, &network, bits));
+
+        QuantError error;
+        quant_measure_error(
+            &network, &quant, boards.data(), boards.size(), &error);
+
+        REQUIRE(error.afterstates > 0);
+        REQUIRE(error.mean_abs <
+                error.mean_value * (bits == QUANT_INT16 ? 1e-3 : 5e-2));
+
+        // The AVX2 gathers and the scalar loop read the same weights.
+        for (Board board : boards) {
+            quant.simd  = false;
+            float value = quant_evaluate(&quant, board);
+            quant.simd  = true;
+            REQUIRE(fabsf(evaluate_quant(board, &quant) - value) <=
+                    1e-4f * (1.0f + fabsf(value)));
+        }
+
+        const char* path = "ntuple_quant_test.bin";
+        REQUIRE(quant_save(&quant, path));
+        NTupleNetwork rejected;
+        REQUIRE_FALSE(ntuple_load(&rejected, path));
+
+        QuantNetwork loaded;
+        REQUIRE(quant_load(&loaded, path));
+        REQUIRE(loaded.bits == bits);
+        loaded.simd = false;
+        quant.simd  = false;
+        REQUIRE(quant_evaluate(&loaded, boards[0]) ==
+                quant_evaluate(&quant, boards[0]));
+
+        remove(path);
+        destroy_quant_network(&loaded);
+        destroy_quant_network(&quant);
+    }
+
+    destroy_ntuple_network(&network);
+}
+
+TEST_CASE("Heuristic tables score rows and columns", "[heuristic]") {
+    HeuristicWeights weights;
+    init_heuristic_weights(&weights);
+
+    Heuristic serial;
+    init_heuristic(&serial, &weights, NULL);
+
+    // Empty lines only earn the base and the empty cells.
+    REQUIRE(heuristic_evaluate(&serial, 0) ==
+            8.0f * (weights.base + 4.0f * weights.empty));
+
+    const int ordered[4][4] = { { 4, 3, 2, 1 },
+                                { 0, 0, 0, 0 },
+                                { 0, 0, 0, 0 },
+                                { 0, 0, 0, 0 } };
+    const int shuffled[4][4] = { { 4, 1, 3, 2 },
+                                 { 0, 0, 0, 0 },
+                                 { 0, 0, 0, 0 },
+                                 { 0, 0, 0, 0 } };
+    Board a = board_from_rows(ordered);
+    Board b = board_from_rows(shuffled);
+
+    REQUIRE(heuristic_evaluate(&serial, a) >
+            heuristic_evaluate(&serial, b));
+    REQUIRE(heuristic_evaluate(&serial, board_transpose(a)) ==
+            heuristic_evaluate(&serial, a));
+    REQUIRE(evaluate_heuristic(a, NULL) ==
+            heuristic_evaluate(&serial, a));
+
+    REQUIRE(heuristic_parse_weights("empty=100,sum_power=2.5", &weights));
+    REQUIRE(weights.empty == 100.0f);
+    REQUIRE(weights.sum_power == 2.5f);
+    REQUIRE_FALSE(heuristic_parse_weights("empty=", &weights));
+    REQUIRE_FALSE(heuristic_parse_weights("bogus=1", &weights));
+
+    ThreadPool pool;
+    init_thread_pool(&pool, 4);
+
+    Heuristic parallel;
+    init_heuristic(&parallel, &weights, &pool);
+    heuristic_set_weights(&serial, &weights, NULL);
+
+    for (int row = 0; row < HEURISTIC_ROWS; row++) {
+        REQUIRE(parallel.line_scores[row] == serial.line_scores[row]);
+    }
+
+    // Batches, including a tail that misses the vector width, sum in
+    // the same order as single boards.
+    Rng rng;
+    init_rng(&rng, 7);
+
+    Board boards[103];
+    float values[103];
+
+    for (Board& board : boards) board = rng_next(&rng);
+
+    heuristic_evaluate_batch(&serial, boards, values, 103);
+    for (int i = 0; i < 103; i++) {
+        REQUIRE(values[i] == heuristic_evaluate(&serial, boards[i]));
+    }
+
+    destroy_heuristic(&parallel);
+    destroy_heuristic(&serial);
+    destroy_thread_pool(&pool);
+}
+
+TEST_CASE("Iterative deepening ends on the fixed-depth answer", "[ai]") {
+    const int rows[4][4] = { { 1, 0, 0, 2 },
+                             { 3, 0, 1, 0 },
+                             { 0, 4, 0, 0 },
+                             { 1, 0, 0, 0 } };
+    Board board          = board_from_rows(rows);
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth = 3;
+
+    SearchResult fixed;
+    ai_search(board, &config, &fixed);
+
+    SearchControl control;
+    init_search_control(&control);
+    config.iterative = true;
+    config.control   = &control;
+
+    SearchResult iterative;
+    ai_search(board, &config, &iterative);
+
+    REQUIRE(iterative.best == fixed.best);
+    REQUIRE(iterative.value == fixed.value);
+    REQUIRE(iterative.depth == 3);
+    REQUIRE_FALSE(iterative.timed_out);
+    REQUIRE(control.depth.load() == 3);
+    REQUIRE(control.best.load() == (int)fixed.best);
+}
+
+TEST_CASE("A cancelled search returns its deepest answer", "[ai]") {
+    const int rows[4][4] = { { 1, 0, 0, 0 },
+                             { 0, 0, 0, 0 },
+                             { 0, 0, 2, 0 },
+                             { 0, 0, 0, 0 } };
+    Board board          = board_from_rows(rows);
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth = 12;
+    config.iterative = true;
+
+    SearchControl control;
+    init_search_control(&control);
+    config.control = &control;
+
+    SearchResult result;
+    std::thread search([&] { ai_search(board, &config, &result); });
+
+    // Wait for a real answer before pulling the plug.
+    while (control.depth.load(std::memory_order_acquire) < 2) {
+        std::this_thread::yield();
+    }
+    search_control_cancel(&control);
+    search.join();
+
+    REQUIRE(result.timed_out);
+    REQUIRE(result.depth >= 2);
+    REQUIRE(result.depth < 12);
+    REQUIRE(result.depth == control.depth.load());
+    REQUIRE(result.best == (Direction)control.best.load());
+    REQUIRE(board_can_move(board, result.best));
+}
+
+TEST_CASE("Symmetries commute with moves", "[symmetry]") {
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+    for (int trial = 0; trial < 1000; trial++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        Board board = x & 0x3333333333333333ULL;
+
+        Board images[SYMMETRY_COUNT];
+        board_symmetries(board, images);
+
+        int s_canon;
+        Board canon = board_canonical(board, &s_canon);
+        REQUIRE(board_symmetry(board, s_canon) == canon);
+
+        for (int s = 0; s < SYMMETRY_COUNT; s++) {
+            REQUIRE(images[s] == board_symmetry(board, s));
+            REQUIRE(board_canonical(images[s], NULL) == canon);
+            REQUIRE(board_symmetry(images[s], symmetry_inverse(s)) ==
+                    board);
+
+            for (int d = 0; d < DIR_COUNT; d++) {
+                Direction dir    = (Direction)d;
+                Direction mapped = symmetry_map_direction(dir, s);
+
+                REQUIRE(board_move(images[s], mapped, NULL) ==
+                        board_symmetry(board_move(board, dir, NULL), s));
+                REQUIRE(symmetry_unmap_direction(mapped, s) == dir);
+            }
+        }
+    }
+}
+
+TEST_CASE("A canonical table shares entries between images",
+          "[ttable]") {
+    TransTable table;
+    init_trans_table(&table, 1);
+    table.canonical = true;
+
+    const int rows[4][4] = { { 1, 2, 0, 0 },
+                             { 0, 3, 0, 0 },
+                             { 0, 0, 0, 4 },
+                             { 0, 0, 0, 0 } };
+    Board board          = board_from_rows(rows);
+    float value          = 0.0f;
+
+    tt_store(&table, board, 3, 42.0f);
+
+    for (int s = 0; s < SYMMETRY_COUNT; s++) {
+        REQUIRE(tt_probe(&table, board_symmetry(board, s), 3, &value));
+        REQUIRE(value == 42.0f);
+    }
+
+    destroy_trans_table(&table);
+}
+
+/*
+ * Plain memoized expectimax over a 2x2 board, to check the solver.
+ */
+static double solve_2x2(BoardN<2> board,
+                        std::map<uint64_t, double>* memo) {
+    auto it = memo->find(board.words[0]);
+    if (it != memo->end()) return it->second;
+
+    double best = 0.0;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        uint32_t gain  = 0;
+        BoardN<2> next = board_n_move(board, (Direction)dir, &gain);
+
+        if (next == board) continue;
+
+        double sum = 0.0;
+        int empty  = 0;
+
+        for (int cell = 0; cell < 4; cell++) {
+            if (board_n_get_tile(next, cell / 2, cell % 2) != 0) continue;
+
+            BoardN<2> two = next, four = next;
+            board_n_set_tile(&two, cell / 2, cell % 2, 1);
+            board_n_set_tile(&four, cell / 2, cell % 2, 2);
+
+            sum += 0.9 * solve_2x2(two, memo) + 0.1 * solve_2x2(four, memo);
+            empty++;
+        }
+
+        best = std::max(best, gain + sum / empty);
+    }
+
+    (*memo)[board.words[0]] = best;
+
+    return best;
+}
+
+TEST_CASE("2x2 tablebase matches a plain expectimax", "[tablebase]") {
+    for (int s = 0; s < SYMMETRY_COUNT; s++) {
+        BoardN<3> board = { { 0x120300201ULL } };
+        BoardN<3> image = board_n_symmetry(board, s);
+
+        for (int d = 0; d < DIR_COUNT; d++) {
+            Direction dir = (Direction)d;
+
+            REQUIRE(board_n_move(image,
+                                 symmetry_map_direction(dir, s),
+                                 (uint32_t*)NULL) ==
+                    board_n_symmetry(
+                        board_n_move(board, dir, (uint32_t*)NULL), s));
+        }
+    }
+
+    ThreadPool pool;
+    init_thread_pool(&pool, 2);
+
+    SolveConfig config;
+    init_solve_config(&config);
+    config.size = 2;
+    config.pool = &pool;
+
+    const char* path = "tablebase_test.bin";
+    SolveStats stats;
+    REQUIRE(solve_tablebase(&config, path, &stats));
+    REQUIRE(stats.positions == 110);
+
+    Tablebase tablebase;
+    REQUIRE(open_tablebase(&tablebase, path));
+    REQUIRE(tablebase.count == 110);
+
+    std::map<uint64_t, double> memo;
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+
+    for (int game = 0; game < 200; game++) {
+        BoardN<2> board = {};
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        board = board_n_spawn(board, (uint32_t)x);
+        board = board_n_spawn(board, (uint32_t)(x >> 32));
+
+        for (;;) {
+            Direction best;
+            float value;
+
+            REQUIRE(tablebase_probe(&tablebase, board.words[0], &best, &value));
+            REQUIRE(fabs(value - solve_2x2(board, &memo)) < 1e-3);
+
+            if (best == DIR_COUNT) break;
+
+            REQUIRE(board_n_can_move(board, best));
+
+            x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+            board = board_n_spawn(board_n_move(board, best, (uint32_t*)NULL),
+                                  (uint32_t)x);
+        }
+    }
+
+    close_tablebase(&tablebase);
+    remove(path);
+    destroy_thread_pool(&pool);
+}
+
+TEST_CASE("RNG streams are reproducible and batched draws match",
+          "[rng]") {
+    // First outputs of the xoshiro256** reference from state 1, 2, 3, 4.
+    Rng reference = { { 1, 2, 3, 4 } };
+    REQUIRE(rng_next(&reference) == 11520);
+    REQUIRE(rng_next(&reference) == 0);
+
+    Rng a, b;
+    init_rng_stream(&a, 7, 3);
+    init_rng_stream(&b, 7, 3);
+    for (int i = 0; i < 100; i++) REQUIRE(rng_next(&a) == rng_next(&b));
+
+    init_rng_stream(&b, 7, 4);
+    REQUIRE(rng_next(&a) != rng_next(&b));
+
+    // The batch fill consumes exactly the draws a loop would.
+    init_rng(&a, 42);
+    init_rng(&b, 42);
+
+    uint32_t bits[7];
+    rng_fill_spawns(&a, bits, 7);
+
+    for (int i = 0; i < 6; i += 2) {
+        uint64_t value = rng_next(&b);
+        REQUIRE(bits[i] == (uint32_t)(value >> 32));
+        REQUIRE(bits[i + 1] == (uint32_t)value);
+    }
+    REQUIRE(bits[6] == rng_next32(&b));
+    REQUIRE(rng_next(&a) == rng_next(&b));
+
+    Rng jumped = a;
+    rng_jump(&jumped);
+    REQUIRE(rng_next(&jumped) != rng_next(&a));
+
+    int counts[3] = { 0, 0, 0 };
+    for (int i = 0; i < 30000; i++) counts[rng_below(&a, 3)]++;
+    for (int count : counts) REQUIRE(abs(count - 10000) < 500);
+}
+
+TEST_CASE("Hint service answers only the latest board", "[hint]") {
+    init_board_tables();
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth = 2;
+
+    HintService service;
+    init_hint_service(&service, &config);
+
+    Board first  = 0x0000000000000011ULL;
+    Board second = 0x0000000000002101ULL;
+
+    hint_post(&service, first);
+    uint64_t latest = hint_post(&service, second);
+
+    HintResult result;
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (!hint_poll(&service, &result) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(result.generation == latest);
+    REQUIRE(result.board == second);
+
+    SearchResult direct;
+    ai_search(second, &config, &direct);
+    REQUIRE(result.best == direct.best);
+
+    // Nothing else is pending, stale or not.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE_FALSE(hint_poll(&service, &result));
+
+    // A search without a budget still stops at destroy.
+    config.max_depth = 12;
+    HintService deep;
+    init_hint_service(&deep, &config);
+    hint_post(&deep, 0x0000000100210312ULL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    destroy_hint_service(&deep);
+
+    destroy_hint_service(&service);
+}
+
+TEST_CASE("Hint service stops right after a post", "[hint]") {
+    init_board_tables();
+
+    SearchConfig config;
+    init_search_config(&config);
+    config.max_depth = 12; // no budget, only a cancel ends it.
+
+    // Destroy lands anywhere from before the worker takes the board to
+    // the middle of its search, and must stop it every time.
+    for (int i = 0; i < 200; i++) {
+        HintService service;
+        init_hint_service(&service, &config);
+        hint_post(&service, 0x0000000100210312ULL);
+        destroy_hint_service(&service);
+    }
+}
+
+TEST_CASE("Datasets round trip and catch damaged blocks", "[dataset]") {
+    REQUIRE(dataset_crc32("123456789", 9) == 0xCBF43926);
+
+    const char* path = "dataset_test.bin";
+    DatasetWriter writer;
+    REQUIRE(init_dataset_writer(&writer, path));
+
+    // Appends from several threads, crossing block boundaries.
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&writer, t] {
+            std::vector<DatasetRecord> game(3000);
+
+            for (uint32_t i = 0; i < game.size(); i++) {
+                game[i]       = DatasetRecord();
+                game[i].board = i;
+                game[i].game  = t;
+                game[i].ply   = (uint16_t)i;
+            }
+            dataset_append(&writer, game.data(), game.size());
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    REQUIRE(destroy_dataset_writer(&writer));
+    REQUIRE(writer.records == 12000);
+    REQUIRE(writer.blocks == 3);
+
+    DatasetStats stats;
+    REQUIRE(dataset_verify(path, &stats));
+    REQUIRE(stats.records == 12000);
+    REQUIRE(stats.blocks == 3);
+    REQUIRE(stats.games == 4);
+
+    // Flip one byte inside the second block.
+    FILE* file = fopen(path, "r+b");
+    REQUIRE(file);
+    fseek(file, 16 + 8 + DATASET_BLOCK_RECORDS * 24 + 8 + 100, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, -1, SEEK_CUR);
+    fputc(byte ^ 1, file);
+    fclose(file);
+
+    REQUIRE_FALSE(dataset_verify(path, &stats));
+    REQUIRE(stats.bad_blocks == 1);
+
+    remove(path);
+}
+
+TEST_CASE("Move server batches requests across clients", "[server]") {
+    init_board_tables();
+
+    ServerConfig config;
+    init_server_config(&config);
+    config.batch_wait_us = 2000;
+
+    const char* path = "server_test.sock";
+    AiServer server;
+    REQUIRE(init_ai_server(&server, &config, path));
+
+    std::thread serving([&server] { ai_server_run(&server); });
+
+    const int CLIENTS  = 4;
+    const int PIPELINE = 32;
+    std::vector<std::thread> clients;
+    std::vector<int> ok(CLIENTS, 0);
+    std::vector<uint32_t> max_batch(CLIENTS, 0);
+
+    for (int c = 0; c < CLIENTS; c++) {
+        clients.emplace_back([&, c] {
+            int fd = ai_client_connect(path);
+            if (fd < 0) return;
+
+            ServerRequest requests[PIPELINE];
+            ServerResponse responses[PIPELINE];
+            Rng rng;
+            init_rng(&rng, (uint64_t)c);
+
+            for (int i = 0; i < PIPELINE; i++) {
+                Board board = 0;
+                for (int k = 0; k < 6; k++) {
+                    board = board_spawn(board, rng_next32(&rng));
+                }
+                requests[i] = { (uint32_t)i, 0, board };
+            }
+
+            if (ai_client_query(fd, requests, responses, PIPELINE)) {
+                int matches = 0;
+
+                for (int i = 0; i < PIPELINE; i++) {
+                    Board board      = requests[i].board;
+                    int best         = DIR_COUNT;
+                    float best_value = 0.0f;
+
+                    for (int d = 0; d < DIR_COUNT; d++) {
+                        uint32_t gain = 0;
+                        Board next =
+                            board_move(board, (Direction)d, &gain);
+
+                        if (next == board) continue;
+
+                        float value =
+                            gain + evaluate_heuristic(next, NULL);
+                        if (best == DIR_COUNT || value > best_value) {
+                            best       = d;
+                            best_value = value;
+                        }
+                    }
+
+                    matches += responses[i].id == (uint32_t)i &&
+                               responses[i].best == best;
+                    max_batch[c] =
+                        std::max(max_batch[c], responses[i].batch);
+                }
+                ok[c] = matches == PIPELINE;
+            }
+
+            close(fd);
+        });
+    }
+    for (std::thread& client : clients) client.join();
+
+    ai_server_stop(&server);
+    serving.join();
+    destroy_ai_server(&server);
+
+    for (int c = 0; c < CLIENTS; c++) {
+        REQUIRE(ok[c]);
+        REQUIRE(max_batch[c] >= (uint32_t)PIPELINE);
+    }
+    REQUIRE(server.stats.requests == CLIENTS * PIPELINE);
+    REQUIRE(server.stats.connections == CLIENTS);
+}
+
+TEST_CASE("Move server stops reading clients that fall behind", "[server]") {
+    init_board_tables();
+
+    ServerConfig config;
+    init_server_config(&config);
+    config.max_client_pending = 4;
+    config.max_client_out     = sizeof(ServerResponse);
+
+    const char* path = "server_cap_test.sock";
+    AiServer server;
+    REQUIRE(init_ai_server(&server, &config, path));
+
+    std::thread serving([&server] { ai_server_run(&server); });
+
+    const int PIPELINE = 64;
+    ServerRequest requests[PIPELINE];
+    ServerResponse responses[PIPELINE];
+    Rng rng;
+    init_rng(&rng, 7);
+
+    for (int i = 0; i < PIPELINE; i++) {
+        requests[i] = { (uint32_t)i, 0, board_spawn(0, rng_next32(&rng)) };
+    }
+
+    int fd  = ai_client_connect(path);
+    bool ok = fd >= 0 && ai_client_query(fd, requests, responses, PIPELINE);
+    if (fd >= 0) close(fd);
+
+    ai_server_stop(&server);
+    serving.join();
+    destroy_ai_server(&server);
+
+    REQUIRE(ok);
+    for (int i = 0; i < PIPELINE; i++) {
+        REQUIRE(responses[i].id == (uint32_t)i);
+        REQUIRE(responses[i].batch <= 4);
+    }
+}
+
+TEST_CASE("Move server only replaces stale sockets", "[server]") {
+    ServerConfig config;
+    init_server_config(&config);
+
+    const char* path = "server_path_test.sock";
+    FILE* file       = fopen(path, "w");
+    REQUIRE(file);
+    fclose(file);
+
+    AiServer server, other;
+    REQUIRE_FALSE(init_ai_server(&server, &config, path));
+    REQUIRE(remove(path) == 0);
+
+    REQUIRE(init_ai_server(&server, &config, path));
+    REQUIRE_FALSE(init_ai_server(&other, &config, path));
+
+    // Gone without unlinking its socket, as after a crash.
+    close(server.listen_fd);
+    REQUIRE(init_ai_server(&other, &config, path));
+    destroy_ai_server(&other);
+}
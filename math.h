@@ -11,6 +11,10 @@ struct Vec3 {
     float x, y, z;
 };
 
+struct Vec4 {
+    float x, y, z, w;
+};
+
 void print_mat4x4(const char* typ, Mat4x4 mat);
 
 void mat4x4_ortho(Mat4x4 out,
@@ -0,0 +1,213 @@
+#include "./montecarlo.h"
+#include "./board_batch.h"
+#include "./rng.h"
+#include "./thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+// Rollouts stepped together by one task.
+const int MC_CHUNK_SIZE = 64;
+
+struct RolloutChunk {
+    const McConfig* config;
+    Board start;      // board after the candidate move.
+    uint32_t gain;    // score of the candidate move.
+    uint64_t stream;  // generator stream of config->seed.
+    int count;
+    uint32_t* scores; // count final scores, written by the task.
+    uint64_t moves;
+};
+
+void init_mc_config(McConfig* config) {
+    config->rollouts   = 100;
+    config->max_moves  = 0;
+    config->policy     = ROLLOUT_RANDOM;
+    config->objective  = MC_OBJECTIVE_MEAN;
+    config->percentile = 0.5f;
+    config->seed       = 1;
+    config->pool       = NULL;
+}
+
+static void run_chunk(void* arg) {
+    RolloutChunk* chunk    = (RolloutChunk*)arg;
+    const McConfig* config = chunk->config;
+    int count              = chunk->count;
+
+    Rng rng;
+    init_rng_stream(&rng, config->seed, chunk->stream);
+
+    vector<Board> boards(count);
+    vector<int> live(count);
+    vector<Board> from(4 * count), to(4 * count);
+    vector<Direction> dirs(4 * count);
+    vector<uint32_t> gains(4 * count);
+    vector<uint32_t> bits(2 * count);
+
+    rng_fill_spawns(&rng, bits.data(), count);
+
+    for (int i = 0; i < count; i++) {
+        boards[i]        = board_spawn(chunk->start, bits[i]);
+        chunk->scores[i] = chunk->gain;
+        live[i]          = i;
+    }
+
+    int live_count = count;
+    int step       = 0;
+
+    while (live_count > 0 &&
+           (config->max_moves <= 0 || step < config->max_moves)) {
+        // Every live board is tried in all four directions at once.
+        for (int j = 0; j < live_count; j++) {
+            for (int d = 0; d < DIR_COUNT; d++) {
+                from[4 * j + d] = boards[live[j]];
+                dirs[4 * j + d] = (Direction)d;
+            }
+        }
+
+        board_move_batch(from.data(),
+                         dirs.data(),
+                         to.data(),
+                         gains.data(),
+                         4 * live_count);
+
+        // Two draws per board: one picks the move, one the spawn.
+        rng_fill_spawns(&rng, bits.data(), 2 * live_count);
+
+        int next_live = 0;
+
+        for (int j = 0; j < live_count; j++) {
+            int legal[DIR_COUNT];
+            int legal_count = 0;
+
+            for (int d = 0; d < DIR_COUNT; d++) {
+                if (to[4 * j + d] != from[4 * j + d]) {
+                    legal[legal_count++] = 4 * j + d;
+                }
+            }
+
+            // No legal move: the rollout is over.
+            if (legal_count == 0) continue;
+
+            // Greedy keeps only the best scoring moves and breaks ties
+            // at random.
+            if (config->policy == ROLLOUT_GREEDY) {
+                uint32_t best_gain = 0;
+                int best_count     = 0;
+
+                for (int k = 0; k < legal_count; k++) {
+                    best_gain = max(best_gain, gains[legal[k]]);
+                }
+                for (int k = 0; k < legal_count; k++) {
+                    if (gains[legal[k]] == best_gain) {
+                        legal[best_count++] = legal[k];
+                    }
+                }
+                legal_count = best_count;
+            }
+
+            int pick = legal[((uint64_t)bits[2 * j] * legal_count) >> 32];
+            int i    = live[j];
+
+            boards[i] = board_spawn(to[pick], bits[2 * j + 1]);
+            chunk->scores[i] += gains[pick];
+            chunk->moves++;
+
+            live[next_live++] = i;
+        }
+
+        live_count = next_live;
+        step++;
+    }
+}
+
+static float reduce_scores(vector<uint32_t>& scores,
+                           const McConfig* config) {
+    if (config->objective == MC_OBJECTIVE_PERCENTILE) {
+        size_t rank = (size_t)(config->percentile *
+                               (float)(scores.size() - 1));
+        nth_element(scores.begin(), scores.begin() + rank, scores.end());
+
+        return (float)scores[rank];
+    }
+
+    double sum = 0.0;
+    for (uint32_t score : scores) sum += score;
+
+    return (float)(sum / (double)scores.size());
+}
+
+void mc_search(Board board, const McConfig* config, McResult* result) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    int rollouts = config->rollouts > 0 ? config->rollouts : 1;
+    vector<uint32_t> scores[DIR_COUNT];
+    vector<RolloutChunk> chunks;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        uint32_t gain = 0;
+        Board next    = board_move(board, (Direction)dir, &gain);
+
+        if (next == board) continue;
+
+        scores[dir].resize(rollouts);
+
+        for (int first = 0; first < rollouts; first += MC_CHUNK_SIZE) {
+            RolloutChunk chunk;
+
+            chunk.config = config;
+            chunk.start  = next;
+            chunk.gain   = gain;
+            chunk.stream = ((uint64_t)dir << 32) | (uint64_t)first;
+            chunk.count  = min(MC_CHUNK_SIZE, rollouts - first);
+            chunk.scores = scores[dir].data() + first;
+            chunk.moves  = 0;
+
+            chunks.push_back(chunk);
+        }
+    }
+
+    if (config->pool) {
+        TaskGroup group;
+
+        for (RolloutChunk& chunk : chunks) {
+            thread_pool_submit(config->pool, &group, &run_chunk, &chunk);
+        }
+        thread_pool_wait(config->pool, &group);
+    } else {
+        for (RolloutChunk& chunk : chunks) run_chunk(&chunk);
+    }
+
+    result->best     = DIR_COUNT;
+    result->rollouts = 0;
+    result->moves    = 0;
+
+    for (const RolloutChunk& chunk : chunks) {
+        result->rollouts += chunk.count;
+        result->moves    += chunk.moves;
+    }
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        result->value[dir] = 0.0f;
+
+        if (scores[dir].empty()) continue;
+
+        result->value[dir] = reduce_scores(scores[dir], config);
+
+        if (result->best == DIR_COUNT ||
+            result->value[dir] > result->value[result->best]) {
+            result->best = (Direction)dir;
+        }
+    }
+
+    result->elapsed_us = (uint64_t)chrono::duration_cast<
+                             chrono::microseconds>(
+                             chrono::steady_clock::now() - start)
+                             .count();
+    result->rollouts_per_sec = result->elapsed_us > 0 ?
+        (double)result->rollouts * 1e6 / (double)result->elapsed_us :
+        0.0;
+}
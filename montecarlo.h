@@ -0,0 +1,61 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "board.h"
+
+#include <cstdint>
+
+struct ThreadPool;
+
+enum RolloutPolicy {
+    ROLLOUT_RANDOM, // uniformly random legal move.
+    ROLLOUT_GREEDY  // legal move with the highest immediate score.
+};
+
+enum McObjective {
+    MC_OBJECTIVE_MEAN,      // best mean final score.
+    MC_OBJECTIVE_PERCENTILE // best score at the given percentile.
+};
+
+struct McConfig {
+    int rollouts;  // rollouts per candidate move.
+    int max_moves; // rollout length cap, 0 plays to game over.
+    RolloutPolicy policy;
+    McObjective objective;
+    float percentile; // in [0, 1], for MC_OBJECTIVE_PERCENTILE.
+    uint64_t seed;
+
+    // Rollouts are split in chunks that run as pool tasks when set.
+    ThreadPool* pool;
+};
+
+struct McResult {
+    Direction best; // DIR_COUNT when no move is legal.
+    float value[DIR_COUNT];
+    uint64_t rollouts;
+    uint64_t moves; // moves played over all rollouts.
+    uint64_t elapsed_us;
+    double rollouts_per_sec;
+};
+
+/*
+ * Fills config with 100 random rollouts per move to game over,
+ * ranked by mean score, seed 1 and no thread pool.
+ */
+void init_mc_config(McConfig* config);
+
+/*
+ * Pure Monte Carlo move selection.
+ *
+ * Every legal move is followed by config->rollouts games played by
+ * the rollout policy, stepped in lockstep through board_move_batch.
+ * A move is worth the final scores of its rollouts, counting the
+ * score of the move itself, reduced by the objective.
+ *
+ * Every chunk of rollouts draws from its own generator seeded from
+ * config->seed, the move and the chunk index, so the result does not
+ * depend on the number of threads.
+ */
+void mc_search(Board board, const McConfig* config, McResult* result);
+
+#endif // !MONTECARLO_H
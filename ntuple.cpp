@@ -0,0 +1,401 @@
+#include "./ntuple.h"
+#include "./rng.h"
+#include "./thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// clang-format off
+const NTuplePattern NTUPLE_PATTERNS_6X4[4] = {
+    { 6, { 0, 1, 2, 3, 4, 5 } },
+    { 6, { 4, 5, 6, 7, 8, 9 } },
+    { 6, { 0, 1, 2, 4, 5, 6 } },
+    { 6, { 4, 5, 6, 8, 9, 10 } },
+};
+
+const NTuplePattern NTUPLE_PATTERNS_4X5[5] = {
+    { 4, { 0, 1, 2, 3 } },
+    { 4, { 4, 5, 6, 7 } },
+    { 4, { 0, 1, 4, 5 } },
+    { 4, { 1, 2, 5, 6 } },
+    { 4, { 5, 6, 9, 10 } },
+};
+// clang-format on
+
+const uint32_t NTUPLE_FILE_MAGIC   = 0x5055544E; // "NTUP"
+const uint32_t NTUPLE_FILE_VERSION = 1;
+
+// Floats per cache line, every table starts on one.
+const size_t NTUPLE_ALIGN_FLOATS = 16;
+
+static size_t table_size(const NTuplePattern* pattern) {
+    return (size_t)1 << (4 * pattern->length);
+}
+
+static bool valid_pattern(const NTuplePattern* pattern) {
+    if (pattern->length < 1 || pattern->length > NTUPLE_MAX_LENGTH) {
+        return false;
+    }
+    for (int i = 0; i < pattern->length; i++) {
+        if (pattern->cells[i] < 0 || pattern->cells[i] >= 16) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool init_ntuple_network(NTupleNetwork* network,
+                         const NTuplePattern* patterns,
+                         int pattern_count) {
+    network->pattern_count = 0;
+    network->weights       = NULL;
+    network->weight_count  = 0;
+
+    if (pattern_count < 1 || pattern_count > NTUPLE_MAX_PATTERNS) {
+        return false;
+    }
+
+    size_t total = 0;
+
+    for (int p = 0; p < pattern_count; p++) {
+        if (!valid_pattern(&patterns[p])) return false;
+
+        size_t size = table_size(&patterns[p]);
+        total += (size + NTUPLE_ALIGN_FLOATS - 1) /
+                 NTUPLE_ALIGN_FLOATS * NTUPLE_ALIGN_FLOATS;
+    }
+
+    float* weights = (float*)aligned_alloc(64, total * sizeof(float));
+    if (!weights) return false;
+
+    memset(weights, 0, total * sizeof(float));
+
+    size_t offset = 0;
+
+    for (int p = 0; p < pattern_count; p++) {
+        size_t size = table_size(&patterns[p]);
+
+        network->patterns[p] = patterns[p];
+        network->tables[p]   = weights + offset;
+        offset += (size + NTUPLE_ALIGN_FLOATS - 1) /
+                  NTUPLE_ALIGN_FLOATS * NTUPLE_ALIGN_FLOATS;
+    }
+
+    network->pattern_count = pattern_count;
+    network->weights       = weights;
+    network->weight_count  = total;
+
+    return true;
+}
+
+void destroy_ntuple_network(NTupleNetwork* network) {
+    free(network->weights);
+
+    network->pattern_count = 0;
+    network->weights       = NULL;
+    network->weight_count  = 0;
+}
+
+static size_t pattern_index(const NTuplePattern* pattern, Board board) {
+    size_t index = 0;
+
+    for (int i = 0; i < pattern->length; i++) {
+        index |= (size_t)((board >> (4 * pattern->cells[i])) & 0xF)
+                 << (4 * i);
+    }
+
+    return index;
+}
+
+float ntuple_evaluate(const NTupleNetwork* network, Board board) {
+    Board boards[NTUPLE_SYMMETRIES];
+    float value = 0.0f;
+
+    board_symmetries(board, boards);
+
+    for (int p = 0; p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        const float* table           = network->tables[p];
+
+        for (Board b : boards) value += table[pattern_index(pattern, b)];
+    }
+
+    return value;
+}
+
+void ntuple_update(NTupleNetwork* network, Board board, float delta) {
+    Board boards[NTUPLE_SYMMETRIES];
+
+    board_symmetries(board, boards);
+
+    for (int p = 0; p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        float* table                 = network->tables[p];
+
+        for (Board b : boards) table[pattern_index(pattern, b)] += delta;
+    }
+}
+
+float evaluate_ntuple(Board board, const void* ctx) {
+    return ntuple_evaluate((const NTupleNetwork*)ctx, board);
+}
+
+void evaluate_ntuple_batch(const Board* boards,
+                           float* values,
+                           size_t count,
+                           const void* ctx) {
+    const NTupleNetwork* network = (const NTupleNetwork*)ctx;
+
+    for (size_t i = 0; i < count; i++) {
+        values[i] = ntuple_evaluate(network, boards[i]);
+    }
+}
+
+bool ntuple_save(const NTupleNetwork* network, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    uint32_t header[3] = { NTUPLE_FILE_MAGIC,
+                           NTUPLE_FILE_VERSION,
+                           (uint32_t)network->pattern_count };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (int p = 0; ok && p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        uint32_t fields[1 + NTUPLE_MAX_LENGTH];
+
+        fields[0] = (uint32_t)pattern->length;
+        for (int i = 0; i < pattern->length; i++) {
+            fields[1 + i] = (uint32_t)pattern->cells[i];
+        }
+
+        ok = fwrite(fields, sizeof(uint32_t), 1 + pattern->length, file) ==
+             (size_t)(1 + pattern->length);
+    }
+
+    for (int p = 0; ok && p < network->pattern_count; p++) {
+        size_t size = table_size(&network->patterns[p]);
+
+        ok = fwrite(network->tables[p], sizeof(float), size, file) == size;
+    }
+
+    if (fclose(file) != 0) ok = false;
+
+    return ok;
+}
+
+bool ntuple_load(NTupleNetwork* network, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    NTuplePattern patterns[NTUPLE_MAX_PATTERNS];
+    uint32_t header[3];
+
+    bool ok = fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == NTUPLE_FILE_MAGIC &&
+              header[1] == NTUPLE_FILE_VERSION && header[2] >= 1 &&
+              header[2] <= (uint32_t)NTUPLE_MAX_PATTERNS;
+
+    int pattern_count = ok ? (int)header[2] : 0;
+
+    for (int p = 0; ok && p < pattern_count; p++) {
+        uint32_t length;
+        uint32_t cells[NTUPLE_MAX_LENGTH];
+
+        ok = fread(&length, sizeof(length), 1, file) == 1 &&
+             length >= 1 && length <= (uint32_t)NTUPLE_MAX_LENGTH &&
+             fread(cells, sizeof(uint32_t), length, file) == length;
+
+        patterns[p].length = (int)length;
+        for (uint32_t i = 0; ok && i < length; i++) {
+            patterns[p].cells[i] = (int)cells[i];
+        }
+    }
+
+    ok = ok && init_ntuple_network(network, patterns, pattern_count);
+
+    for (int p = 0; ok && p < pattern_count; p++) {
+        size_t size = table_size(&network->patterns[p]);
+
+        ok = fread(network->tables[p], sizeof(float), size, file) == size;
+        if (!ok) destroy_ntuple_network(network);
+    }
+
+    fclose(file);
+
+    return ok;
+}
+
+void init_train_config(TrainConfig* config) {
+    config->games  = 1000;
+    config->alpha  = 0.1f;
+    config->lambda = 0.0f;
+    config->seed   = 1;
+    config->pool   = NULL;
+}
+
+struct TrainWorker {
+    NTupleNetwork* network;
+    const TrainConfig* config;
+    atomic<int>* next_game;
+    uint64_t games;
+    uint64_t moves;
+    uint64_t total_score;
+    uint32_t best_score;
+    int reached[16];
+};
+
+static void train_game(TrainWorker* worker,
+                       uint64_t game,
+                       vector<Board>& after,
+                       vector<uint32_t>& rewards) {
+    NTupleNetwork* network = worker->network;
+    float lambda           = worker->config->lambda;
+    int lookups            = network->pattern_count * NTUPLE_SYMMETRIES;
+    float step             = worker->config->alpha / (float)lookups;
+
+    Rng rng;
+    init_rng_stream(&rng, worker->config->seed, game);
+
+    Board board    = board_spawn(0, rng_next32(&rng));
+    board          = board_spawn(board, rng_next32(&rng));
+    uint32_t score = 0;
+
+    after.clear();
+    rewards.clear();
+
+    for (;;) {
+        Board best_next    = board;
+        uint32_t best_gain = 0;
+        float best_value   = 0.0f;
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            uint32_t gain = 0;
+            Board next    = board_move(board, (Direction)dir, &gain);
+
+            if (next == board) continue;
+
+            float value =
+                (float)gain + ntuple_evaluate(network, next);
+
+            if (best_next == board || value > best_value) {
+                best_next  = next;
+                best_gain  = gain;
+                best_value = value;
+            }
+        }
+
+        if (best_next == board) break;
+
+        after.push_back(best_next);
+        rewards.push_back(best_gain);
+        score += best_gain;
+
+        board = board_spawn(best_next, rng_next32(&rng));
+    }
+
+    // Backward pass: the return of afterstate t mixes the one-step
+    // target r + V(next afterstate) with the return of the next one.
+    float next_return = 0.0f;
+
+    for (size_t t = after.size(); t-- > 0;) {
+        float target = 0.0f;
+
+        if (t + 1 < after.size()) {
+            float next_value = ntuple_evaluate(network, after[t + 1]);
+
+            target = (float)rewards[t + 1] +
+                     (1.0f - lambda) * next_value +
+                     lambda * next_return;
+        }
+
+        float error = target - ntuple_evaluate(network, after[t]);
+        ntuple_update(network, after[t], step * error);
+
+        next_return = target;
+    }
+
+    int max_tile = board_max_tile(board);
+
+    worker->games++;
+    worker->moves       += after.size();
+    worker->total_score += score;
+    if (score > worker->best_score) worker->best_score = score;
+    for (int tile = 1; tile <= max_tile; tile++) worker->reached[tile]++;
+}
+
+static void run_train_worker(void* arg) {
+    TrainWorker* worker = (TrainWorker*)arg;
+    vector<Board> after;
+    vector<uint32_t> rewards;
+
+    for (;;) {
+        int game = worker->next_game->fetch_add(1, memory_order_relaxed);
+
+        if (game >= worker->config->games) break;
+
+        train_game(worker, (uint64_t)game, after, rewards);
+    }
+}
+
+void ntuple_train(NTupleNetwork* network,
+                  const TrainConfig* config,
+                  TrainStats* stats) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    int worker_count = config->pool ? thread_pool_size(config->pool) : 1;
+    atomic<int> next_game(0);
+    vector<TrainWorker> workers(worker_count);
+
+    for (TrainWorker& worker : workers) {
+        memset(&worker, 0, sizeof(worker));
+        worker.network   = network;
+        worker.config    = config;
+        worker.next_game = &next_game;
+    }
+
+    if (config->pool) {
+        TaskGroup group;
+
+        for (TrainWorker& worker : workers) {
+            thread_pool_submit(
+                config->pool, &group, &run_train_worker, &worker);
+        }
+        thread_pool_wait(config->pool, &group);
+    } else {
+        run_train_worker(&workers[0]);
+    }
+
+    uint64_t total_score = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (const TrainWorker& worker : workers) {
+        stats->games += worker.games;
+        stats->moves += worker.moves;
+        total_score  += worker.total_score;
+        if (worker.best_score > stats->best_score) {
+            stats->best_score = worker.best_score;
+        }
+        for (int tile = 0; tile < 16; tile++) {
+            stats->reached[tile] += worker.reached[tile];
+        }
+    }
+
+    stats->mean_score = stats->games > 0 ?
+        (double)total_score / (double)stats->games :
+        0.0;
+    stats->elapsed_us = (uint64_t)chrono::duration_cast<
+                            chrono::microseconds>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+    stats->games_per_sec = stats->elapsed_us > 0 ?
+        (double)stats->games * 1e6 / (double)stats->elapsed_us :
+        0.0;
+}
@@ -0,0 +1,130 @@
+#ifndef NTUPLE_H
+#define NTUPLE_H
+
+#include "board.h"
+#include "symmetry.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct ThreadPool;
+
+const int NTUPLE_MAX_PATTERNS = 8;
+const int NTUPLE_MAX_LENGTH   = 6;
+const int NTUPLE_SYMMETRIES   = SYMMETRY_COUNT;
+
+/*
+ * A set of board cells, given as nibble indices (row * 4 + col).
+ * The tile exponents found there, read in order, index a table of
+ * 16^length weights.
+ */
+struct NTuplePattern {
+    int length;
+    int cells[NTUPLE_MAX_LENGTH];
+};
+
+/*
+ * Afterstate value function: the sum, over every pattern and each of
+ * the 8 rotations and reflections of the board, of one looked up
+ * weight. Looking a pattern up in every image of the board is the
+ * same as looking up its 8 symmetric copies, which share the table.
+ *
+ * All tables live in one 64-byte aligned block, each starting on a
+ * cache line of its own.
+ */
+struct NTupleNetwork {
+    int pattern_count;
+    NTuplePattern patterns[NTUPLE_MAX_PATTERNS];
+    float* tables[NTUPLE_MAX_PATTERNS];
+    float* weights;
+    size_t weight_count;
+};
+
+// Four 6-cell patterns, 256 MB of weights. The strong default.
+extern const NTuplePattern NTUPLE_PATTERNS_6X4[4];
+
+// Rows, columns and squares of 4 cells, 1.25 MB. Trains in seconds.
+extern const NTuplePattern NTUPLE_PATTERNS_4X5[5];
+
+/*
+ * Allocates zeroed weights for the patterns. Returns false when the
+ * patterns are invalid or the memory can't be had.
+ */
+bool init_ntuple_network(NTupleNetwork* network,
+                         const NTuplePattern* patterns,
+                         int pattern_count);
+
+void destroy_ntuple_network(NTupleNetwork* network);
+
+float ntuple_evaluate(const NTupleNetwork* network, Board board);
+
+/*
+ * Adds delta to every weight board looks up.
+ */
+void ntuple_update(NTupleNetwork* network, Board board, float delta);
+
+/*
+ * Evaluator adapter, ctx is the NTupleNetwork. The network values an
+ * afterstate by the score still to come, so a search using it must set
+ * add_rewards to rank moves as training did.
+ */
+float evaluate_ntuple(Board board, const void* ctx);
+
+// BatchEvaluator adapter, ctx is the NTupleNetwork.
+void evaluate_ntuple_batch(const Board* boards,
+                           float* values,
+                           size_t count,
+                           const void* ctx);
+
+/*
+ * Checkpoints are the patterns followed by the raw weights, in host
+ * byte order. ntuple_load initializes network from the file, which
+ * the caller destroys as usual.
+ */
+bool ntuple_save(const NTupleNetwork* network, const char* path);
+
+bool ntuple_load(NTupleNetwork* network, const char* path);
+
+struct TrainConfig {
+    int games;
+    float alpha;  // learning rate, spread over all lookups of a board.
+    float lambda; // 0 for TD(0).
+    uint64_t seed;
+
+    // Games are played by one task per pool thread when set.
+    ThreadPool* pool;
+};
+
+struct TrainStats {
+    uint64_t games;
+    uint64_t moves;
+    double mean_score;
+    uint32_t best_score;
+    int reached[16]; // games whose max tile reached each exponent.
+    uint64_t elapsed_us;
+    double games_per_sec;
+};
+
+/*
+ * Fills config with 1000 games, alpha 0.1, TD(0), seed 1 and no
+ * thread pool.
+ */
+void init_train_config(TrainConfig* config);
+
+/*
+ * Temporal difference learning of afterstate values by self-play.
+ *
+ * Every move is the one with the best reward plus afterstate value.
+ * At the end of a game its afterstates are updated from last to
+ * first towards their lambda-returns, the last one towards 0.
+ *
+ * Threads share the network and write weights without any locking
+ * (Hogwild). Two updates racing on one weight may lose one, which
+ * costs less than any synchronization would. Training is therefore
+ * only reproducible with a single thread.
+ */
+void ntuple_train(NTupleNetwork* network,
+                  const TrainConfig* config,
+                  TrainStats* stats);
+
+#endif // !NTUPLE_H
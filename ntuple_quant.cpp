@@ -0,0 +1,408 @@
+#include "./ntuple_quant.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NTUPLE_QUANT_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+const uint32_t QUANT_FILE_MAGIC   = 0x5155544E; // "NTUQ"
+const uint32_t QUANT_FILE_VERSION = 1;
+
+// The gathers read 4 bytes per weight, so the last table of the
+// block needs a few bytes of slack behind it.
+const size_t QUANT_GATHER_SLACK = 64;
+
+static size_t table_size(const NTuplePattern* pattern) {
+    return (size_t)1 << (4 * pattern->length);
+}
+
+static size_t table_bytes(const NTuplePattern* pattern, QuantBits bits) {
+    size_t bytes = table_size(pattern) * (bits / 8);
+
+    return (bytes + 63) / 64 * 64;
+}
+
+/*
+ * Allocates zeroed tables for the patterns, leaving the scales alone.
+ */
+static bool alloc_tables(QuantNetwork* network,
+                         const NTuplePattern* patterns,
+                         int pattern_count,
+                         QuantBits bits) {
+    network->pattern_count = 0;
+    network->weights       = NULL;
+    network->bytes         = 0;
+
+    if (pattern_count < 1 || pattern_count > NTUPLE_MAX_PATTERNS) {
+        return false;
+    }
+    if (bits != QUANT_INT8 && bits != QUANT_INT16) return false;
+
+    size_t total = 0;
+
+    for (int p = 0; p < pattern_count; p++) {
+        total += table_bytes(&patterns[p], bits);
+    }
+
+    char* weights =
+        (char*)aligned_alloc(64, total + QUANT_GATHER_SLACK);
+    if (!weights) return false;
+
+    memset(weights, 0, total + QUANT_GATHER_SLACK);
+
+    size_t offset = 0;
+
+    for (int p = 0; p < pattern_count; p++) {
+        network->patterns[p] = patterns[p];
+        network->tables[p]   = weights + offset;
+        offset += table_bytes(&patterns[p], bits);
+    }
+
+    network->pattern_count = pattern_count;
+    network->bits          = bits;
+    network->weights       = weights;
+    network->bytes         = total;
+#ifdef NTUPLE_QUANT_X86
+    network->simd = __builtin_cpu_supports("avx2");
+#else
+    network->simd = false;
+#endif
+
+    return true;
+}
+
+bool init_quant_network(QuantNetwork* network,
+                        const NTupleNetwork* source,
+                        QuantBits bits) {
+    if (!alloc_tables(
+            network, source->patterns, source->pattern_count, bits)) {
+        return false;
+    }
+
+    float limit = bits == QUANT_INT16 ? 32767.0f : 127.0f;
+
+    for (int p = 0; p < network->pattern_count; p++) {
+        const float* weights = source->tables[p];
+        size_t size          = table_size(&network->patterns[p]);
+        float max_abs        = 0.0f;
+
+        for (size_t i = 0; i < size; i++) {
+            max_abs = fmaxf(max_abs, fabsf(weights[i]));
+        }
+
+        float scale        = max_abs > 0.0f ? max_abs / limit : 1.0f;
+        network->scales[p] = scale;
+
+        for (size_t i = 0; i < size; i++) {
+            float q = fminf(fmaxf(rintf(weights[i] / scale), -limit),
+                            limit);
+
+            if (bits == QUANT_INT16) {
+                ((int16_t*)network->tables[p])[i] = (int16_t)q;
+            } else {
+                ((int8_t*)network->tables[p])[i] = (int8_t)q;
+            }
+        }
+    }
+
+    return true;
+}
+
+void destroy_quant_network(QuantNetwork* network) {
+    free(network->weights);
+
+    network->pattern_count = 0;
+    network->weights       = NULL;
+    network->bytes         = 0;
+}
+
+static float quant_evaluate_scalar(const QuantNetwork* network,
+                                   Board board) {
+    Board boards[NTUPLE_SYMMETRIES];
+    float value = 0.0f;
+
+    board_symmetries(board, boards);
+
+    for (int p = 0; p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        int32_t sum                  = 0;
+
+        for (Board b : boards) {
+            size_t index = 0;
+
+            for (int i = 0; i < pattern->length; i++) {
+                index |= (size_t)((b >> (4 * pattern->cells[i])) & 0xF)
+                         << (4 * i);
+            }
+
+            sum += network->bits == QUANT_INT16 ?
+                ((const int16_t*)network->tables[p])[index] :
+                ((const int8_t*)network->tables[p])[index];
+        }
+
+        value += (float)sum * network->scales[p];
+    }
+
+    return value;
+}
+
+#ifdef NTUPLE_QUANT_X86
+
+TARGET_AVX2 static float quant_evaluate_avx2(const QuantNetwork* network,
+                                             Board board) {
+    Board boards[NTUPLE_SYMMETRIES];
+
+    board_symmetries(board, boards);
+
+    // Split the 8 boards into their low and high 32 bits, one board
+    // per lane: cells 0-7 are then nibbles of lo, cells 8-15 of hi.
+    const __m256i split  = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i nibble = _mm256_set1_epi32(0xF);
+
+    __m256i a = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256((const __m256i*)boards), split);
+    __m256i b = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256((const __m256i*)(boards + 4)), split);
+    __m256i lo = _mm256_permute2x128_si256(a, b, 0x20);
+    __m256i hi = _mm256_permute2x128_si256(a, b, 0x31);
+
+    int shift     = network->bits == QUANT_INT16 ? 16 : 24;
+    int elem_size = network->bits / 8;
+    __m256 sum    = _mm256_setzero_ps();
+
+    for (int p = 0; p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        __m256i index                = _mm256_setzero_si256();
+
+        for (int i = 0; i < pattern->length; i++) {
+            int cell = pattern->cells[i];
+
+            __m256i tile = _mm256_and_si256(
+                _mm256_srl_epi32(cell < 8 ? lo : hi,
+                                 _mm_cvtsi32_si128(4 * (cell & 7))),
+                nibble);
+            index = _mm256_or_si256(
+                index,
+                _mm256_sll_epi32(tile, _mm_cvtsi32_si128(4 * i)));
+        }
+
+        // Each lane reads 4 bytes starting at its weight, the weight
+        // is the low 2 or 1 of them, sign extended.
+        __m256i weights =
+            elem_size == 2 ?
+            _mm256_i32gather_epi32(
+                (const int*)network->tables[p], index, 2) :
+            _mm256_i32gather_epi32(
+                (const int*)network->tables[p], index, 1);
+
+        weights = _mm256_srai_epi32(_mm256_slli_epi32(weights, shift),
+                                    shift);
+
+        sum = _mm256_add_ps(
+            sum,
+            _mm256_mul_ps(_mm256_cvtepi32_ps(weights),
+                          _mm256_set1_ps(network->scales[p])));
+    }
+
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum),
+                             _mm256_extractf128_ps(sum, 1));
+    half        = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half        = _mm_add_ss(half, _mm_movehdup_ps(half));
+
+    return _mm_cvtss_f32(half);
+}
+
+#endif // NTUPLE_QUANT_X86
+
+float quant_evaluate(const QuantNetwork* network, Board board) {
+#ifdef NTUPLE_QUANT_X86
+    if (network->simd) return quant_evaluate_avx2(network, board);
+#endif
+    return quant_evaluate_scalar(network, board);
+}
+
+void quant_evaluate_batch(const QuantNetwork* network,
+                          const Board* boards,
+                          float* values,
+                          size_t count) {
+#ifdef NTUPLE_QUANT_X86
+    if (network->simd) {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = quant_evaluate_avx2(network, boards[i]);
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++) {
+        values[i] = quant_evaluate_scalar(network, boards[i]);
+    }
+}
+
+float evaluate_quant(Board board, const void* ctx) {
+    return quant_evaluate((const QuantNetwork*)ctx, board);
+}
+
+void evaluate_quant_batch(const Board* boards,
+                          float* values,
+                          size_t count,
+                          const void* ctx) {
+    quant_evaluate_batch((const QuantNetwork*)ctx, boards, values, count);
+}
+
+bool quant_save(const QuantNetwork* network, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    uint32_t header[4] = { QUANT_FILE_MAGIC,
+                           QUANT_FILE_VERSION,
+                           (uint32_t)network->bits,
+                           (uint32_t)network->pattern_count };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (int p = 0; ok && p < network->pattern_count; p++) {
+        const NTuplePattern* pattern = &network->patterns[p];
+        uint32_t fields[1 + NTUPLE_MAX_LENGTH];
+
+        fields[0] = (uint32_t)pattern->length;
+        for (int i = 0; i < pattern->length; i++) {
+            fields[1 + i] = (uint32_t)pattern->cells[i];
+        }
+
+        ok = fwrite(fields, sizeof(uint32_t), 1 + pattern->length, file) ==
+             (size_t)(1 + pattern->length);
+    }
+
+    ok = ok && fwrite(network->scales,
+                      sizeof(float),
+                      network->pattern_count,
+                      file) == (size_t)network->pattern_count;
+
+    for (int p = 0; ok && p < network->pattern_count; p++) {
+        size_t size = table_size(&network->patterns[p]);
+
+        ok = fwrite(network->tables[p], network->bits / 8, size, file) ==
+             size;
+    }
+
+    if (fclose(file) != 0) ok = false;
+
+    return ok;
+}
+
+bool quant_load(QuantNetwork* network, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    NTuplePattern patterns[NTUPLE_MAX_PATTERNS];
+    float scales[NTUPLE_MAX_PATTERNS];
+    uint32_t header[4];
+
+    bool ok = fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == QUANT_FILE_MAGIC &&
+              header[1] == QUANT_FILE_VERSION &&
+              (header[2] == QUANT_INT8 || header[2] == QUANT_INT16) &&
+              header[3] >= 1 &&
+              header[3] <= (uint32_t)NTUPLE_MAX_PATTERNS;
+
+    int pattern_count = ok ? (int)header[3] : 0;
+
+    for (int p = 0; ok && p < pattern_count; p++) {
+        uint32_t length;
+        uint32_t cells[NTUPLE_MAX_LENGTH];
+
+        ok = fread(&length, sizeof(length), 1, file) == 1 &&
+             length >= 1 && length <= (uint32_t)NTUPLE_MAX_LENGTH &&
+             fread(cells, sizeof(uint32_t), length, file) == length;
+
+        patterns[p].length = (int)length;
+        for (uint32_t i = 0; ok && i < length; i++) {
+            ok                   = cells[i] < 16;
+            patterns[p].cells[i] = (int)cells[i];
+        }
+    }
+
+    ok = ok && fread(scales, sizeof(float), pattern_count, file) ==
+                   (size_t)pattern_count;
+    ok = ok && alloc_tables(
+                   network, patterns, pattern_count, (QuantBits)header[2]);
+
+    for (int p = 0; ok && p < pattern_count; p++) {
+        size_t size = table_size(&network->patterns[p]);
+
+        network->scales[p] = scales[p];
+
+        ok = fread(network->tables[p], network->bits / 8, size, file) ==
+             size;
+        if (!ok) destroy_quant_network(network);
+    }
+
+    fclose(file);
+
+    return ok;
+}
+
+void quant_measure_error(const NTupleNetwork* reference,
+                         const QuantNetwork* network,
+                         const Board* boards,
+                         size_t count,
+                         QuantError* error) {
+    double sum_abs = 0.0, sum_sq = 0.0, sum_value = 0.0;
+    uint64_t agree = 0;
+
+    memset(error, 0, sizeof(*error));
+
+    for (size_t i = 0; i < count; i++) {
+        int best_float = -1, best_quant = -1;
+        float best_float_value = 0.0f, best_quant_value = 0.0f;
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            uint32_t gain = 0;
+            Board next    = board_move(boards[i], (Direction)dir, &gain);
+
+            if (next == boards[i]) continue;
+
+            float vf  = ntuple_evaluate(reference, next);
+            float vq  = quant_evaluate(network, next);
+            double ae = fabs((double)vq - (double)vf);
+
+            error->afterstates++;
+            sum_abs   += ae;
+            sum_sq    += ae * ae;
+            sum_value += fabs((double)vf);
+            if (ae > error->max_abs) error->max_abs = ae;
+
+            if (best_float < 0 || gain + vf > best_float_value) {
+                best_float       = dir;
+                best_float_value = gain + vf;
+            }
+            if (best_quant < 0 || gain + vq > best_quant_value) {
+                best_quant       = dir;
+                best_quant_value = gain + vq;
+            }
+        }
+
+        if (best_float < 0) continue;
+
+        error->positions++;
+        if (best_float == best_quant) agree++;
+    }
+
+    if (error->afterstates > 0) {
+        double n          = (double)error->afterstates;
+        error->mean_abs   = sum_abs / n;
+        error->rms        = sqrt(sum_sq / n);
+        error->mean_value = sum_value / n;
+    }
+    if (error->positions > 0) {
+        error->move_agreement =
+            (double)agree / (double)error->positions;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef NTUPLE_QUANT_H
+#define NTUPLE_QUANT_H
+
+#include "ntuple.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum QuantBits { QUANT_INT8 = 8, QUANT_INT16 = 16 };
+
+/*
+ * Inference-only copy of an NTupleNetwork with integer weights.
+ *
+ * Every table has its own scale, set by its largest weight, and a
+ * weight is q * scale. int16 tables are half the size of the float
+ * ones and int8 tables a quarter, so the default 6-tuple network
+ * drops from 256 MB to 128 or 64 MB.
+ */
+struct QuantNetwork {
+    int pattern_count;
+    NTuplePattern patterns[NTUPLE_MAX_PATTERNS];
+    QuantBits bits;
+    float scales[NTUPLE_MAX_PATTERNS];
+    void* tables[NTUPLE_MAX_PATTERNS]; // int16_t or int8_t.
+    void* weights;
+    size_t bytes;
+
+    // Evaluate with AVX2 gathers, set by init when the CPU has them.
+    bool simd;
+};
+
+struct QuantError {
+    uint64_t positions;
+    uint64_t afterstates;
+    double mean_abs; // mean |quantized - float| afterstate value.
+    double max_abs;
+    double rms;
+    double mean_value;     // mean |float| value, for scale.
+    double move_agreement; // share of positions with the same move.
+};
+
+/*
+ * Rounds the weights of source to the nearest step of their table's
+ * scale. Returns false when memory can't be had.
+ */
+bool init_quant_network(QuantNetwork* network,
+                        const NTupleNetwork* source,
+                        QuantBits bits);
+
+void destroy_quant_network(QuantNetwork* network);
+
+/*
+ * Same sum as ntuple_evaluate. The AVX2 path computes the 8
+ * symmetric indices of a pattern in one vector and gathers all 8
+ * weights at once.
+ */
+float quant_evaluate(const QuantNetwork* network, Board board);
+
+/*
+ * quant_evaluate of count boards, with the kernel picked once for the
+ * whole batch. A board already fills the AVX2 vector with its 8
+ * symmetries, so boards go through one after the other.
+ */
+void quant_evaluate_batch(const QuantNetwork* network,
+                          const Board* boards,
+                          float* values,
+                          size_t count);
+
+// Evaluator adapter, ctx is the QuantNetwork. Like evaluate_ntuple,
+// it needs add_rewards.
+float evaluate_quant(Board board, const void* ctx);
+
+// BatchEvaluator adapter, ctx is the QuantNetwork.
+void evaluate_quant_batch(const Board* boards,
+                          float* values,
+                          size_t count,
+                          const void* ctx);
+
+/*
+ * Same layout as ntuple_save with the bit width and the scales added.
+ * ntuple_load rejects these files and quant_load rejects float ones.
+ */
+bool quant_save(const QuantNetwork* network, const char* path);
+
+bool quant_load(QuantNetwork* network, const char* path);
+
+/*
+ * Compares the two networks on every afterstate of boards, and on
+ * the move each would pick from them.
+ */
+void quant_measure_error(const NTupleNetwork* reference,
+                         const QuantNetwork* network,
+                         const Board* boards,
+                         size_t count,
+                         QuantError* error);
+
+#endif // !NTUPLE_QUANT_H
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "board.h"
+#include "ntuple.h"
+#include "ntuple_quant.h"
+#include "rng.h"
+
+using namespace std;
+
+/*
+ * Quantizes a float n-tuple checkpoint and reports what it costs.
+ *
+ * Positions are sampled from games played by the float network, so
+ * the error is measured where the search actually looks. Reports the
+ * value error, how often the best move changes, table sizes and the
+ * evaluation rate of both networks.
+ */
+
+static vector<Board> sample_positions(const NTupleNetwork* network,
+                                      size_t count,
+                                      uint64_t seed) {
+    vector<Board> positions;
+    Rng rng;
+    init_rng(&rng, seed);
+
+    while (positions.size() < count) {
+        Board board = board_spawn(0, rng_next32(&rng));
+        board       = board_spawn(board, rng_next32(&rng));
+
+        while (positions.size() < count) {
+            Board best_next  = board;
+            float best_value = 0.0f;
+
+            for (int dir = 0; dir < DIR_COUNT; dir++) {
+                uint32_t gain = 0;
+                Board next    = board_move(board, (Direction)dir, &gain);
+
+                if (next == board) continue;
+
+                float value = gain + ntuple_evaluate(network, next);
+                if (best_next == board || value > best_value) {
+                    best_next  = next;
+                    best_value = value;
+                }
+            }
+
+            if (best_next == board) break;
+
+            positions.push_back(board);
+            board = board_spawn(best_next, rng_next32(&rng));
+        }
+    }
+
+    return positions;
+}
+
+template <typename F>
+static double evals_per_sec(const vector<Board>& positions, F evaluate) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    volatile float sink = 0.0f;
+
+    for (Board board : positions) sink = sink + evaluate(board);
+
+    double sec = chrono::duration<double>(
+                     chrono::steady_clock::now() - start)
+                     .count();
+
+    return sec > 0.0 ? positions.size() / sec : 0.0;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s --weights FILE [--bits 16|8] [--out FILE]\n"
+            "    [--positions N] [--seed S]\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* weights_path = NULL;
+    const char* out_path     = NULL;
+    int bits                 = 16;
+    size_t count             = 100000;
+    uint64_t seed            = 1;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--weights") == 0 && has_value) {
+            weights_path = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--bits") == 0 && has_value) {
+            bits = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--positions") == 0 && has_value) {
+            count = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!weights_path || (bits != 8 && bits != 16) || count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    init_board_tables();
+
+    NTupleNetwork network;
+    QuantNetwork quant;
+
+    if (!ntuple_load(&network, weights_path)) {
+        fprintf(stderr, "could not load %s\n", weights_path);
+        return 1;
+    }
+    if (!init_quant_network(&quant, &network, (QuantBits)bits)) {
+        fprintf(stderr, "could not allocate the quantized network\n");
+        destroy_ntuple_network(&network);
+        return 1;
+    }
+
+    vector<Board> positions = sample_positions(&network, count, seed);
+    QuantError error;
+    quant_measure_error(
+        &network, &quant, positions.data(), positions.size(), &error);
+
+    double float_rate = evals_per_sec(positions, [&](Board b) {
+        return ntuple_evaluate(&network, b);
+    });
+    double quant_rate = evals_per_sec(positions, [&](Board b) {
+        return quant_evaluate(&quant, b);
+    });
+
+    printf("positions:      %llu (%llu afterstates)\n",
+           (unsigned long long)error.positions,
+           (unsigned long long)error.afterstates);
+    printf("mean |value|:   %.3f\n", error.mean_value);
+    printf("mean abs error: %.4f (%.4f%%)\n",
+           error.mean_abs,
+           error.mean_value > 0.0 ?
+               100.0 * error.mean_abs / error.mean_value :
+               0.0);
+    printf("max abs error:  %.4f\n", error.max_abs);
+    printf("rms error:      %.4f\n", error.rms);
+    printf("same move:      %.3f%%\n", 100.0 * error.move_agreement);
+    printf("table size:     %.1f MB float, %.1f MB int%d\n",
+           network.weight_count * sizeof(float) / 1048576.0,
+           quant.bytes / 1048576.0,
+           bits);
+    printf("evals/s:        %.0f float, %.0f int%d (%s)\n",
+           float_rate,
+           quant_rate,
+           bits,
+           quant.simd ? "avx2" : "scalar");
+
+    bool ok = true;
+
+    if (out_path) {
+        ok = quant_save(&quant, out_path);
+        if (!ok) fprintf(stderr, "could not write %s\n", out_path);
+    }
+
+    destroy_quant_network(&quant);
+    destroy_ntuple_network(&network);
+
+    return ok ? 0 : 1;
+}
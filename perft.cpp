@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "board.h"
+
+using namespace std;
+
+/*
+ * Move generation benchmark in the style of chess perft.
+ *
+ * perft(board, depth) counts the boards reached after depth rounds of
+ * "any legal move, then any spawn" (every empty cell, both a 2 and a
+ * 4). The leaf counts pin down the move engine's behaviour, the rate
+ * tracks its speed.
+ */
+
+struct PerftPosition {
+    const char* name;
+    Board board;
+    int depth;
+    uint64_t leaves; // reference count at depth.
+};
+
+// Counts were cross-checked against a cell-by-cell move
+// implementation that does not use the row tables.
+static const PerftPosition positions[] = {
+    { "opening", 0x0000000000000011ULL, 4, 82675002ULL },
+    { "midgame", 0x0000120001300021ULL, 4, 30272452ULL },
+    { "crowded", 0x1234234134122100ULL, 6, 199582536ULL },
+    { "checkers", 0x2121121221211200ULL, 6, 221292248ULL },
+    { "dead end", 0x123456789ABCDEF0ULL, 2, 0ULL },
+};
+
+static uint64_t perft(Board board, int depth, uint64_t* moves) {
+    uint64_t leaves = 0;
+
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        Board next = board_move(board, (Direction)dir, NULL);
+
+        if (next == board) continue;
+
+        (*moves)++;
+
+        // Bulk count the last ply: every empty cell takes a 2 or a 4.
+        if (depth == 1) {
+            leaves += 2 * board_count_empty(next);
+            continue;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            if (((next >> (4 * i)) & 0xF) != 0) continue;
+
+            Board two  = next | ((Board)1 << (4 * i));
+            Board four = next | ((Board)2 << (4 * i));
+
+            leaves += perft(two, depth - 1, moves);
+            leaves += perft(four, depth - 1, moves);
+        }
+    }
+
+    return leaves;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--depth D]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    // A depth override skips the reference check.
+    int depth = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    init_board_tables();
+
+    int failures        = 0;
+    uint64_t all_leaves = 0;
+    double all_sec      = 0.0;
+
+    printf("%-10s %5s %12s %12s %10s %12s\n",
+           "position",
+           "depth",
+           "leaves",
+           "moves",
+           "time (s)",
+           "leaves/s");
+
+    for (const PerftPosition& pos : positions) {
+        int d          = depth > 0 ? depth : pos.depth;
+        uint64_t moves = 0;
+
+        chrono::steady_clock::time_point start =
+            chrono::steady_clock::now();
+
+        uint64_t leaves = d > 0 ? perft(pos.board, d, &moves) : 1;
+
+        double sec = chrono::duration<double>(
+                         chrono::steady_clock::now() - start)
+                         .count();
+
+        bool ok = depth > 0 || leaves == pos.leaves;
+        if (!ok) failures++;
+
+        all_leaves += leaves;
+        all_sec    += sec;
+
+        printf("%-10s %5d %12llu %12llu %10.3f %12.0f%s\n",
+               pos.name,
+               d,
+               (unsigned long long)leaves,
+               (unsigned long long)moves,
+               sec,
+               sec > 0.0 ? leaves / sec : 0.0,
+               ok ? "" : "  MISMATCH");
+
+        if (!ok) {
+            printf("%-10s expected %llu\n",
+                   "",
+                   (unsigned long long)pos.leaves);
+        }
+    }
+
+    printf("total: %llu leaves in %.3f s, %.0f leaves/s\n",
+           (unsigned long long)all_leaves,
+           all_sec,
+           all_sec > 0.0 ? all_leaves / all_sec : 0.0);
+
+    return failures > 0 ? 1 : 0;
+}
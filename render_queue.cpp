@@ -0,0 +1,80 @@
+#include "render_queue.h"
+
+#include <cstring>
+
+using namespace std;
+
+uint64_t render_key(int layer, int shader, GLuint texture, uint32_t depth) {
+    return (uint64_t)(layer & 0xff) << 56 | (uint64_t)(shader & 0xff) << 48 |
+           (uint64_t)(texture & 0xffff) << 32 | depth;
+}
+
+void render_queue_push(RenderQueue* queue,
+                       uint64_t key,
+                       const RenderCommand& command) {
+    queue->items.push_back({ key, (uint32_t)queue->commands.size() });
+    queue->commands.push_back(command);
+}
+
+void render_queue_sort(RenderQueue* queue) {
+    size_t n = queue->items.size();
+
+    if (n < 2) return;
+
+    queue->scratch.resize(n);
+
+    RenderSortItem* from = queue->items.data();
+    RenderSortItem* to   = queue->scratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256];
+        memset(counts, 0, sizeof(counts));
+
+        for (size_t i = 0; i < n; i++) {
+            counts[(from[i].key >> shift) & 0xff]++;
+        }
+
+        // Every key has the same byte here, the pass would move nothing.
+        if (counts[(from[0].key >> shift) & 0xff] == n) continue;
+
+        size_t offset = 0;
+
+        for (int digit = 0; digit < 256; digit++) {
+            size_t count  = counts[digit];
+            counts[digit] = offset;
+            offset        += count;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            to[counts[(from[i].key >> shift) & 0xff]++] = from[i];
+        }
+
+        RenderSortItem* swap = from;
+        from                 = to;
+        to                   = swap;
+    }
+
+    if (from != queue->items.data()) queue->items.swap(queue->scratch);
+}
+
+void render_queue_submit(RenderQueue* queue, SpriteBatch* batch) {
+    render_queue_sort(queue);
+
+    for (const RenderSortItem& item : queue->items) {
+        const RenderCommand& command = queue->commands[item.command];
+
+        sprite_batch_add(batch,
+                         command.program,
+                         command.texture,
+                         command.position,
+                         command.size,
+                         command.rotation,
+                         command.uv,
+                         command.tint);
+    }
+
+    sprite_batch_flush(batch);
+
+    queue->commands.clear();
+    queue->items.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "math.h"
+#include "sprite_batch.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL_opengl.h>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Layers draw back to front, whatever order they are queued in.
+ */
+enum RenderLayer {
+    LAYER_BACKGROUND,
+    LAYER_BOARD,
+    LAYER_OVERLAY
+};
+
+/*
+ * A sprite to draw, with the GL state it needs.
+ */
+struct RenderCommand {
+    GLuint program;
+    GLuint texture;
+    Vec2 position;
+    Vec2 size;
+    float rotation;
+    Vec4 uv;
+    Vec4 tint;
+};
+
+struct RenderSortItem {
+    uint64_t key;
+    uint32_t command; // index into RenderQueue::commands.
+};
+
+/*
+ * Commands of a frame, drawn in the order of their sort keys rather
+ * than the order states queue them.
+ *
+ * A key holds, from the most significant bits down, the layer (8
+ * bits), the shader (8), the texture (16) and the depth (32). Within a
+ * layer, commands that share a program and a texture end up next to
+ * each other and go out in one instanced draw. Depth orders the rest.
+ */
+struct RenderQueue {
+    std::vector<RenderCommand> commands;
+    std::vector<RenderSortItem> items;
+    std::vector<RenderSortItem> scratch; // radix sort buffer.
+};
+
+uint64_t render_key(int layer, int shader, GLuint texture, uint32_t depth);
+
+void render_queue_push(RenderQueue* queue,
+                       uint64_t key,
+                       const RenderCommand& command);
+
+/*
+ * Sorts the items by key with a stable LSD radix sort, one byte per
+ * pass, skipping the bytes every key shares.
+ */
+void render_queue_sort(RenderQueue* queue);
+
+/*
+ * Sorts the commands, feeds them to the batch in key order, flushes it
+ * and empties the queue. The batch skips program and texture binds
+ * that would not change anything.
+ */
+void render_queue_submit(RenderQueue* queue, SpriteBatch* batch);
+
+#endif // !RENDER_QUEUE_H
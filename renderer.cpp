@@ -1,12 +1,7 @@
 #include "renderer.h"
 
 
-void add_shader(Renderer* renderer,
-                std::pair<const char*, GLuint> program) {
-    renderer->shaders.insert(program);
-}
-
-void init_renderer(Renderer* renderer) {
+GameError init_renderer(Renderer* renderer) {
 
     // clang-format off
     float verts[] = {
@@ -25,73 +20,88 @@ void init_renderer(Renderer* renderer) {
     // clang-format on
     //
 
-    glGenVertexArrays(1, &renderer->sprite_vao);
     glGenBuffers(1, &renderer->sprite_vbo);
 
     glBindBuffer(GL_ARRAY_BUFFER, renderer->sprite_vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    // A board, its background and a few effects per frame.
+    if (!init_sprite_batch(&renderer->sprites, renderer->sprite_vbo, 256)) {
+        SDL_Log("Failed to map the sprite stream buffer.\n");
+        return GAME_ERROR_BUFFER_MAPPING_FAILED;
+    }
 
-    glBindVertexArray(renderer->sprite_vao);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(
-        0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    return GAME_ERROR_NO_ERROR;
 }
 
-void use_shader(Renderer* renderer, const char* shader) {
-    glUseProgram(renderer->shaders[shader]);
+static void push_sprite(Renderer* renderer,
+                        ShaderId shader,
+                        RenderLayer layer,
+                        GLuint texture,
+                        Vec2 position,
+                        Vec2 size,
+                        float rotate,
+                        Vec4 uv,
+                        Vec4 tint) {
+    RenderQueue* queue = &renderer->queue;
+
+    // Depth is the queue order, sprites keep it within their material.
+    uint64_t key = render_key(
+        layer, shader, texture, (uint32_t)queue->commands.size());
+
+    RenderCommand command;
+
+    command.program  = renderer->shaders[shader].program;
+    command.texture  = texture;
+    command.position = position;
+    command.size     = size;
+    command.rotation = rotate;
+    command.uv       = uv;
+    command.tint     = tint;
+
+    render_queue_push(queue, key, command);
 }
 
-void render_sprite(Game* game,
-                   const char* tex,
-                   Renderer* renderer,
-                   const char* shader,
-                   Vec2 position,
-                   Vec2 size,
-                   float rotate,
-                   Vec3 color) {
-    glUseProgram(renderer->shaders[shader]);
-
-    Mat4x4 model;
-
-    identity(model);
-    // print_mat4x4("Identity Matrix", model);
-
-    // Translate...
-    translate(model, position);
-    // print_mat4x4("I X T", model);
-
-    // Rotate
-    translate(model, { 0.5f * size.x, 0.5f * size.y });
-    rotatez(model, rotate);
-    translate(model, { -0.5f * size.x, -0.5f * size.y });
-    // print_mat4x4("(I X T) X R", model);
-
-    // Scale
-    scale(model, size);
-    // print_mat4x4("((I X T) X R) X S", model);
-
-    glUniformMatrix4fv(glGetUniformLocation(renderer->shaders[shader], "model"),
-                       1,
-                       GL_TRUE,
-                       model[0]);
-
-    const float greenish[] = { 0.03, 0.98f, 0.01f };
-
-    glUniform3fv(glGetUniformLocation(renderer->shaders[shader], "sprite_color"),
-                 1,
-                 greenish);
-
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, game->textures.at(tex));
+void queue_sprite(Game* game,
+                  const char* tex,
+                  Renderer* renderer,
+                  ShaderId shader,
+                  RenderLayer layer,
+                  Vec2 position,
+                  Vec2 size,
+                  float rotate,
+                  Vec4 tint) {
+    push_sprite(renderer,
+                shader,
+                layer,
+                game->atlas.texture,
+                position,
+                size,
+                rotate,
+                game->atlas.regions.at(tex).uv,
+                tint);
+}
 
-    glBindTextureUnit(0, game->textures.at(tex));
+void queue_tile(Game* game,
+                int exponent,
+                Renderer* renderer,
+                ShaderId shader,
+                RenderLayer layer,
+                Vec2 position,
+                Vec2 size,
+                Vec4 tint) {
+    push_sprite(renderer,
+                shader,
+                layer,
+                game->atlas.texture,
+                position,
+                size,
+                0.0f,
+                game->atlas.tile_uv[exponent],
+                tint);
+}
 
-    glBindVertexArray(renderer->sprite_vao);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+void flush_sprites(Renderer* renderer) {
+    render_queue_submit(&renderer->queue, &renderer->sprites);
 }
@@ -3,31 +3,64 @@
 
 #include "game.h"
 #include "math.h"
+#include "render_queue.h"
+#include "shader.h"
+#include "sprite_batch.h"
 
 #define GL_GLEXT_PROTOTYPES
 #include <SDL_opengl.h>
 
-#include <unordered_map>
+/*
+ * The programs of the game, indices into Renderer::shaders.
+ */
+enum ShaderId {
+    SHADER_BATCH,
+    SHADER_COUNT
+};
 
 struct Renderer {
-    std::unordered_map<std::string, GLuint> shaders;
-    GLuint sprite_vao;
-    GLuint sprite_vbo;
+    Shader shaders[SHADER_COUNT];
+    GLuint sprite_vbo; // the unit quad.
+    RenderQueue queue; // see queue_sprite.
+    SpriteBatch sprites;
 };
 
-void use_shader(Renderer* renderer, const char* shader);
+/*
+ * Fails when the sprite batch cannot map its stream buffer.
+ */
+GameError init_renderer(Renderer* renderer);
 
-void add_shader(Renderer* renderer,
-                std::pair<const char*, GLuint> program);
+/*
+ * Queues the atlas image tex scaled to size at position, rotated by
+ * rotate radians about its center and tinted. It is drawn at the next
+ * flush_sprites, in layer order, batched with every other sprite of
+ * its layer that shares its shader.
+ */
+void queue_sprite(Game* game,
+                  const char* tex,
+                  Renderer* renderer,
+                  ShaderId shader,
+                  RenderLayer layer,
+                  Vec2 position,
+                  Vec2 size,
+                  float rotate,
+                  Vec4 tint);
 
-void init_renderer(Renderer* renderer);
+/*
+ * Queues the tile image of 2^exponent, 1 through ATLAS_TILE_COUNT - 1,
+ * by its atlas region without a name lookup.
+ */
+void queue_tile(Game* game,
+                int exponent,
+                Renderer* renderer,
+                ShaderId shader,
+                RenderLayer layer,
+                Vec2 position,
+                Vec2 size,
+                Vec4 tint);
 
-void render_sprite(Game* game,
-                   const char* tex,
-                   Renderer* renderer,
-                   const char* shader,
-                   Vec2 position,
-                   Vec2 size,
-                   float rotate,
-                   Vec3 color);
+/*
+ * Sorts the queued sprites by key and draws them.
+ */
+void flush_sprites(Renderer* renderer);
 #endif
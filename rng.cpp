@@ -0,0 +1,60 @@
+#include "./rng.h"
+
+uint64_t splitmix64(uint64_t* state) {
+    uint64_t x = (*state += 0x9E3779B97F4A7C15ULL);
+
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+
+    return x;
+}
+
+void init_rng(Rng* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&seed);
+}
+
+void init_rng_stream(Rng* rng, uint64_t seed, uint64_t stream) {
+    // Hashing the stream first keeps nearby (seed, stream) pairs, like
+    // seed 1 stream 2 and seed 2 stream 1, apart.
+    uint64_t key = stream;
+
+    init_rng(rng, seed ^ splitmix64(&key));
+}
+
+void rng_jump(Rng* rng) {
+    static const uint64_t jump[4] = { 0x180EC6D33CFD0ABAULL,
+                                      0xD5A61266F0C9392CULL,
+                                      0xA9582618E03FC9AAULL,
+                                      0x39ABDC4529B1661CULL };
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                for (int k = 0; k < 4; k++) s[k] ^= rng->s[k];
+            }
+            rng_next(rng);
+        }
+    }
+
+    for (int k = 0; k < 4; k++) rng->s[k] = s[k];
+}
+
+void rng_fill_spawns(Rng* rng, uint32_t* bits, size_t count) {
+    // Local copy so the state stays in registers across the loop.
+    Rng local = *rng;
+    size_t i  = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        uint64_t value = rng_next(&local);
+
+        bits[i]     = (uint32_t)(value >> 32);
+        bits[i + 1] = (uint32_t)value;
+    }
+    if (i < count) bits[i] = rng_next32(&local);
+
+    *rng = local;
+}
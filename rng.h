@@ -0,0 +1,81 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * xoshiro256** generator. 32 bytes of state and a few cycles per draw,
+ * so every thread, game or rollout chunk owns one by value.
+ *
+ * Streams are reproducible by construction: a stream is named by the
+ * (seed, stream) pair, never by the thread that happens to run it, so
+ * results do not depend on the thread count.
+ */
+struct Rng {
+    uint64_t s[4];
+};
+
+/*
+ * Advances a splitmix64 state and returns its next output. Used to
+ * expand seeds, and handy on its own to hash an index into a seed.
+ */
+uint64_t splitmix64(uint64_t* state);
+
+/*
+ * Seeds rng by running splitmix64 from seed, as the xoshiro authors
+ * recommend. Any seed, including 0, gives a valid state.
+ */
+void init_rng(Rng* rng, uint64_t seed);
+
+/*
+ * Seeds rng with stream number stream of seed. Distinct streams are
+ * hashed to unrelated states, e.g. one stream per game index.
+ */
+void init_rng_stream(Rng* rng, uint64_t seed, uint64_t stream);
+
+/*
+ * Advances rng by 2^128 draws. Calling it k times on copies of one
+ * generator gives k non-overlapping sequences of 2^128 draws each.
+ */
+void rng_jump(Rng* rng);
+
+inline uint64_t rng_next(Rng* rng) {
+    uint64_t* s    = rng->s;
+    uint64_t x     = s[1] * 5;
+    uint64_t t     = s[1] << 17;
+    uint64_t value = ((x << 7) | (x >> 57)) * 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+
+    return value;
+}
+
+/*
+ * The high half of a draw, the better mixed one. This is the
+ * rand_bits board_spawn and board_n_spawn expect.
+ */
+inline uint32_t rng_next32(Rng* rng) {
+    return (uint32_t)(rng_next(rng) >> 32);
+}
+
+/*
+ * Uniform-enough integer in [0, n) by multiply and shift, without the
+ * division of %. The bias is below n / 2^32.
+ */
+inline uint32_t rng_below(Rng* rng, uint32_t n) {
+    return (uint32_t)(((uint64_t)rng_next32(rng) * n) >> 32);
+}
+
+/*
+ * Fills bits with count 32-bit spawn draws, two per generator step.
+ * Rollouts draw the spawns of a whole batch of boards in one call.
+ */
+void rng_fill_spawns(Rng* rng, uint32_t* bits, size_t count);
+
+#endif // !RNG_H
@@ -0,0 +1,460 @@
+#include "./server.h"
+#include "./board_batch.h"
+#include "./heuristic.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// Longest poll while idle, bounds how late a stop is noticed.
+const int SERVER_IDLE_POLL_MS = 100;
+
+struct Client {
+    int fd;
+    vector<char> in;  // bytes of an incomplete request.
+    vector<char> out; // responses not sent yet.
+    size_t pending;   // requests waiting for a batch.
+    bool closed;
+};
+
+struct Pending {
+    Client* client;
+    ServerRequest request;
+    Clock::time_point arrival;
+};
+
+void init_server_config(ServerConfig* config) {
+    config->eval          = { &evaluate_heuristic_batch, NULL };
+    config->max_batch     = 256;
+    config->max_clients        = 64;
+    config->max_client_pending = 1024;
+    config->max_client_out     = 64 * 1024;
+    config->batch_wait_us      = 200;
+}
+
+static uint64_t micros(Clock::duration d) {
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(d).count();
+}
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool make_address(const char* path, sockaddr_un* address) {
+    if (strlen(path) >= sizeof(address->sun_path)) return false;
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, path);
+
+    return true;
+}
+
+/*
+ * Clears the way for bind. Only a socket file that refuses connections,
+ * left behind by a server that is gone, is removed.
+ */
+static bool remove_stale_socket(const sockaddr_un* address) {
+    struct stat info;
+
+    if (lstat(address->sun_path, &info) != 0) return errno == ENOENT;
+    if (!S_ISSOCK(info.st_mode)) return false;
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return false;
+
+    bool stale =
+        connect(probe, (const sockaddr*)address, sizeof(*address)) != 0 &&
+        errno == ECONNREFUSED;
+    close(probe);
+
+    return stale && unlink(address->sun_path) == 0;
+}
+
+bool init_ai_server(AiServer* server,
+                    const ServerConfig* config,
+                    const char* path) {
+    sockaddr_un address;
+    if (!make_address(path, &address)) return false;
+
+    if (!remove_stale_socket(&address)) return false;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    if (bind(fd, (const sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(fd, config->max_clients) != 0 || !set_nonblocking(fd)) {
+        close(fd);
+        return false;
+    }
+
+    server->config    = *config;
+    server->listen_fd = fd;
+    strcpy(server->path, path);
+    server->stopping.store(false);
+    memset(&server->stats, 0, sizeof(server->stats));
+
+    return true;
+}
+
+void destroy_ai_server(AiServer* server) {
+    close(server->listen_fd);
+    unlink(server->path);
+
+    server->listen_fd = -1;
+}
+
+void ai_server_stop(AiServer* server) {
+    server->stopping.store(true);
+}
+
+static bool wants_requests(const AiServer* server, const Client* client) {
+    return client->pending < (size_t)server->config.max_client_pending &&
+           client->out.size() <= server->config.max_client_out;
+}
+
+/*
+ * Reads what the client sent, up to its pending cap, and queues its
+ * complete requests. The rest stays in the socket for later.
+ */
+static void read_requests(const AiServer* server,
+                          Client* client,
+                          deque<Pending>* pending) {
+    char buffer[4096];
+    size_t limit =
+        (size_t)server->config.max_client_pending * sizeof(ServerRequest);
+    size_t held = client->pending * sizeof(ServerRequest) + client->in.size();
+
+    while (held < limit) {
+        ssize_t got = read(
+            client->fd, buffer, min(sizeof(buffer), limit - held));
+
+        if (got > 0) {
+            client->in.insert(client->in.end(), buffer, buffer + got);
+            held += (size_t)got;
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            client->closed = true;
+        }
+        break;
+    }
+
+    Clock::time_point now = Clock::now();
+    size_t whole          = client->in.size() / sizeof(ServerRequest);
+
+    for (size_t i = 0; i < whole; i++) {
+        Pending p;
+
+        p.client  = client;
+        p.arrival = now;
+        memcpy(&p.request,
+               client->in.data() + i * sizeof(ServerRequest),
+               sizeof(ServerRequest));
+
+        pending->push_back(p);
+    }
+    client->pending += whole;
+
+    client->in.erase(client->in.begin(),
+                     client->in.begin() + whole * sizeof(ServerRequest));
+}
+
+static void flush_responses(Client* client) {
+    size_t sent = 0;
+
+    while (sent < client->out.size()) {
+        ssize_t n = send(client->fd,
+                         client->out.data() + sent,
+                         client->out.size() - sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            client->closed = true;
+        }
+        break;
+    }
+
+    client->out.erase(client->out.begin(), client->out.begin() + sent);
+}
+
+/*
+ * Answers the first count pending requests with one batched pass.
+ */
+static void evaluate_batch(AiServer* server,
+                           deque<Pending>* pending,
+                           size_t count) {
+    const BatchEvaluator& eval = server->config.eval;
+    size_t moves               = DIR_COUNT * count;
+
+    vector<Board> from(moves), to(moves);
+    vector<Direction> dirs(moves);
+    vector<uint32_t> gains(moves);
+
+    Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < count; i++) {
+        for (int d = 0; d < DIR_COUNT; d++) {
+            from[DIR_COUNT * i + d] = (*pending)[i].request.board;
+            dirs[DIR_COUNT * i + d] = (Direction)d;
+        }
+    }
+
+    board_move_batch(
+        from.data(), dirs.data(), to.data(), gains.data(), moves);
+
+    // Every legal afterstate of the batch, scored in one call.
+    vector<Board> afterstates;
+    vector<uint32_t> moved; // index into to of each afterstate.
+
+    afterstates.reserve(moves);
+    moved.reserve(moves);
+
+    for (size_t k = 0; k < moves; k++) {
+        if (to[k] == from[k]) continue;
+
+        afterstates.push_back(to[k]);
+        moved.push_back((uint32_t)k);
+    }
+
+    vector<float> values(afterstates.size());
+
+    eval.evaluate(
+        afterstates.data(), values.data(), afterstates.size(), eval.ctx);
+
+    vector<ServerResponse> responses(count);
+
+    for (size_t i = 0; i < count; i++) {
+        ServerResponse& response = responses[i];
+
+        memset(&response, 0, sizeof(response));
+        response.id   = (*pending)[i].request.id;
+        response.best = DIR_COUNT;
+    }
+
+    for (size_t a = 0; a < afterstates.size(); a++) {
+        size_t k                 = moved[a];
+        int d                    = (int)(k % DIR_COUNT);
+        ServerResponse& response = responses[k / DIR_COUNT];
+        float value              = gains[k] + values[a];
+
+        response.values[d] = value;
+
+        if (response.best == DIR_COUNT || value > response.value) {
+            response.best  = (uint8_t)d;
+            response.value = value;
+        }
+    }
+
+    Clock::time_point end = Clock::now();
+    uint64_t eval_us      = micros(end - start);
+
+    for (size_t i = 0; i < count; i++) {
+        Pending& p               = (*pending)[i];
+        ServerResponse& response = responses[i];
+        uint64_t latency_us      = micros(end - p.arrival);
+
+        response.queue_us = (uint32_t)micros(start - p.arrival);
+        response.eval_us  = (uint32_t)eval_us;
+        response.batch    = (uint32_t)count;
+        p.client->pending--;
+
+        const char* bytes = (const char*)&response;
+        p.client->out.insert(p.client->out.end(),
+                             bytes,
+                             bytes + sizeof(response));
+
+        server->stats.total_latency_us += latency_us;
+        server->stats.max_latency_us =
+            max(server->stats.max_latency_us, latency_us);
+    }
+
+    server->stats.requests += count;
+    server->stats.batches++;
+
+    pending->erase(pending->begin(), pending->begin() + count);
+}
+
+bool ai_server_run(AiServer* server) {
+    vector<unique_ptr<Client>> clients;
+    deque<Pending> pending;
+    vector<pollfd> fds;
+    size_t max_batch = (size_t)max(1, server->config.max_batch);
+    bool ok          = true;
+
+    while (!server->stopping.load()) {
+        fds.clear();
+        fds.push_back({ server->listen_fd, POLLIN, 0 });
+
+        for (const unique_ptr<Client>& client : clients) {
+            short events = 0;
+            if (wants_requests(server, client.get())) events |= POLLIN;
+            if (!client->out.empty()) events |= POLLOUT;
+
+            fds.push_back({ client->fd, events, 0 });
+        }
+
+        // A partial batch only waits for the rest of its window.
+        timespec timeout = { 0, SERVER_IDLE_POLL_MS * 1000000L };
+
+        if (!pending.empty()) {
+            uint64_t window = server->config.batch_wait_us;
+            uint64_t waited =
+                micros(Clock::now() - pending.front().arrival);
+            uint64_t left = waited < window ? window - waited : 0;
+
+            timeout.tv_sec  = (time_t)(left / 1000000);
+            timeout.tv_nsec = (long)(left % 1000000) * 1000;
+        }
+
+        if (ppoll(fds.data(), fds.size(), &timeout, NULL) < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client* client = clients[i].get();
+            short revents  = fds[i + 1].revents;
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                read_requests(server, client, &pending);
+            }
+            if (revents & POLLOUT) flush_responses(client);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+
+            while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+                if ((int)clients.size() >= server->config.max_clients ||
+                    !set_nonblocking(fd)) {
+                    close(fd);
+                    continue;
+                }
+
+                unique_ptr<Client> client(new Client);
+                client->fd      = fd;
+                client->pending = 0;
+                client->closed  = false;
+
+                clients.push_back(move(client));
+                server->stats.connections++;
+            }
+        }
+
+        // Evaluate once the batch is full or its window has passed.
+        while (!pending.empty() &&
+               (pending.size() >= max_batch ||
+                micros(Clock::now() - pending.front().arrival) >=
+                    server->config.batch_wait_us)) {
+            evaluate_batch(server, &pending, min(pending.size(), max_batch));
+        }
+
+        for (const unique_ptr<Client>& client : clients) {
+            if (!client->out.empty()) flush_responses(client.get());
+        }
+
+        // Requests of a client that went away are not answered.
+        for (size_t i = 0; i < clients.size();) {
+            Client* client = clients[i].get();
+
+            if (!client->closed) {
+                i++;
+                continue;
+            }
+
+            pending.erase(remove_if(pending.begin(),
+                                    pending.end(),
+                                    [client](const Pending& p) {
+                                        return p.client == client;
+                                    }),
+                          pending.end());
+
+            close(client->fd);
+            clients.erase(clients.begin() + i);
+        }
+    }
+
+    for (const unique_ptr<Client>& client : clients) close(client->fd);
+
+    return ok;
+}
+
+int ai_client_connect(const char* path) {
+    sockaddr_un address;
+    if (!make_address(path, &address)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+
+        bytes += n;
+        size  -= (size_t)n;
+    }
+
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+    char* bytes = (char*)data;
+
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+
+        bytes += n;
+        size  -= (size_t)n;
+    }
+
+    return true;
+}
+
+bool ai_client_query(int fd,
+                     const ServerRequest* requests,
+                     ServerResponse* responses,
+                     size_t count) {
+    return write_all(fd, requests, count * sizeof(ServerRequest)) &&
+           read_all(fd, responses, count * sizeof(ServerResponse));
+}
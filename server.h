@@ -0,0 +1,124 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "ai.h"
+#include "board.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Wire format, fixed size and in host (little endian) order. A client
+ * may send any number of requests before reading, responses come back
+ * in the order the requests were sent.
+ */
+struct ServerRequest {
+    uint32_t id; // echoed back, for the client's bookkeeping.
+    uint32_t reserved;
+    Board board;
+};
+
+struct ServerResponse {
+    uint32_t id;
+    uint8_t best; // Direction, DIR_COUNT when no move is legal.
+    uint8_t reserved[3];
+    float value;             // reward plus afterstate value of best.
+    float values[DIR_COUNT]; // the same for every move, 0 if illegal.
+    uint32_t queue_us; // from the request arriving to its batch starting.
+    uint32_t eval_us;  // time spent evaluating its batch.
+    uint32_t batch;    // requests evaluated together with it.
+};
+
+static_assert(sizeof(ServerRequest) == 16, "requests are 16 bytes");
+static_assert(sizeof(ServerResponse) == 40, "responses are 40 bytes");
+
+struct ServerConfig {
+    BatchEvaluator eval; // afterstate values, e.g. evaluate_quant_batch.
+    int max_batch;       // requests evaluated per pass at most.
+    int max_clients;
+    // A client is not read from while it has max_client_pending
+    // requests waiting or more than max_client_out bytes of responses
+    // it has not taken, so one that never reads cannot grow the queues.
+    int max_client_pending;
+    size_t max_client_out;
+    // How long a partial batch waits for more requests, 0 to evaluate
+    // whatever has arrived right away.
+    uint64_t batch_wait_us;
+};
+
+struct ServerStats {
+    uint64_t requests;
+    uint64_t batches;
+    uint64_t connections;
+    uint64_t total_latency_us; // arrival to response queued, summed.
+    uint64_t max_latency_us;
+};
+
+/*
+ * Answers move requests from any number of local processes over a
+ * Unix domain socket, so they share one copy of the evaluation tables.
+ *
+ * Requests from all clients are gathered into one batch. The batch
+ * goes through a single board_move_batch call for all four moves of
+ * every board, then a single batched evaluator call over every legal
+ * afterstate, and each request gets its best move by reward plus
+ * afterstate value.
+ *
+ * That is a one-ply greedy choice, which is how n-tuple networks are
+ * meant to play: they are trained as afterstate value functions. A
+ * static evaluator such as the heuristic plays much weaker this way
+ * than under expectimax; the server does not search.
+ */
+struct AiServer {
+    ServerConfig config;
+    int listen_fd;
+    char path[108]; // sun_path of the socket, unlinked on destroy.
+    std::atomic<bool> stopping;
+    ServerStats stats;
+};
+
+/*
+ * Fills config with the default heuristic (evaluate_heuristic_batch),
+ * batches of up to 256, 64 clients of at most 1024 pending requests
+ * and 64 KiB of unread responses each, and a 200 us batch window.
+ */
+void init_server_config(ServerConfig* config);
+
+/*
+ * Binds and listens on path, replacing the socket file of a server that
+ * is gone. Fails when a server still answers there or when path is any
+ * other kind of file, which is left alone.
+ */
+bool init_ai_server(AiServer* server,
+                    const ServerConfig* config,
+                    const char* path);
+
+void destroy_ai_server(AiServer* server);
+
+/*
+ * Serves clients until ai_server_stop. Returns false when polling the
+ * sockets fails.
+ */
+bool ai_server_run(AiServer* server);
+
+/*
+ * Makes ai_server_run return within a poll interval. Safe from any
+ * thread and from a signal handler.
+ */
+void ai_server_stop(AiServer* server);
+
+/*
+ * Connects to a server, returns the socket or -1.
+ */
+int ai_client_connect(const char* path);
+
+/*
+ * Sends count requests, then reads their count responses.
+ */
+bool ai_client_query(int fd,
+                     const ServerRequest* requests,
+                     ServerResponse* responses,
+                     size_t count);
+
+#endif // !SERVER_H
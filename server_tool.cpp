@@ -0,0 +1,259 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "board.h"
+#include "ntuple.h"
+#include "ntuple_quant.h"
+#include "rng.h"
+#include "server.h"
+
+using namespace std;
+
+/*
+ * Runs the move server, or hammers one to measure it.
+ *
+ *   serve: answers requests on the socket until SIGINT or SIGTERM,
+ *          then prints what it served.
+ *   bench: clients each send batches of requests for random
+ *          mid-game boards and report throughput and latency.
+ */
+
+static AiServer* running_server = NULL;
+
+static void handle_stop(int) {
+    if (running_server) ai_server_stop(running_server);
+}
+
+static int serve(const char* path,
+                 const char* weights_path,
+                 ServerConfig* config) {
+    init_board_tables();
+
+    NTupleNetwork network;
+    QuantNetwork quant;
+    bool has_network = false, has_quant = false;
+
+    if (weights_path) {
+        if (quant_load(&quant, weights_path)) {
+            has_quant    = true;
+            config->eval = { &evaluate_quant_batch, &quant };
+        } else if (ntuple_load(&network, weights_path)) {
+            has_network  = true;
+            config->eval = { &evaluate_ntuple_batch, &network };
+        } else {
+            fprintf(stderr, "could not load %s\n", weights_path);
+            return 1;
+        }
+    }
+
+    AiServer server;
+
+    if (!init_ai_server(&server, config, path)) {
+        fprintf(stderr, "could not listen on %s\n", path);
+        return 1;
+    }
+
+    running_server = &server;
+    signal(SIGINT, handle_stop);
+    signal(SIGTERM, handle_stop);
+
+    bool ok = ai_server_run(&server);
+
+    running_server = NULL;
+    destroy_ai_server(&server);
+    if (has_network) destroy_ntuple_network(&network);
+    if (has_quant) destroy_quant_network(&quant);
+
+    const ServerStats& stats = server.stats;
+
+    printf("connections:  %llu\n", (unsigned long long)stats.connections);
+    printf("requests:     %llu in %llu batches\n",
+           (unsigned long long)stats.requests,
+           (unsigned long long)stats.batches);
+    if (stats.requests > 0) {
+        printf("latency:      %.1f us mean, %llu us max\n",
+               (double)stats.total_latency_us / stats.requests,
+               (unsigned long long)stats.max_latency_us);
+    }
+
+    return ok ? 0 : 1;
+}
+
+struct BenchClient {
+    const char* path;
+    int rounds;
+    int pipeline;
+    uint64_t seed;
+    bool ok;
+    uint64_t latency_us; // round trips, summed.
+    uint64_t batch;      // batch sizes reported, summed.
+};
+
+static void run_bench_client(BenchClient* client) {
+    int fd = ai_client_connect(client->path);
+
+    client->ok = fd >= 0;
+    if (!client->ok) return;
+
+    Rng rng;
+    init_rng(&rng, client->seed);
+
+    vector<ServerRequest> requests(client->pipeline);
+    vector<ServerResponse> responses(client->pipeline);
+
+    for (int round = 0; round < client->rounds; round++) {
+        for (int i = 0; i < client->pipeline; i++) {
+            Board board = 0;
+            for (int k = 0; k < 8; k++) {
+                board = board_spawn(board, rng_next32(&rng));
+            }
+
+            requests[i].id       = (uint32_t)i;
+            requests[i].reserved = 0;
+            requests[i].board    = board;
+        }
+
+        chrono::steady_clock::time_point start =
+            chrono::steady_clock::now();
+
+        if (!ai_client_query(fd,
+                             requests.data(),
+                             responses.data(),
+                             requests.size())) {
+            client->ok = false;
+            break;
+        }
+
+        client->latency_us +=
+            (uint64_t)chrono::duration_cast<chrono::microseconds>(
+                chrono::steady_clock::now() - start)
+                .count();
+
+        for (const ServerResponse& response : responses) {
+            client->batch += response.batch;
+        }
+    }
+
+    close(fd);
+}
+
+static int bench(const char* path, int clients, int rounds, int pipeline) {
+    init_board_tables();
+
+    vector<BenchClient> states(clients);
+    vector<thread> threads;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < clients; i++) {
+        states[i] = { path, rounds, pipeline, (uint64_t)i + 1, true, 0, 0 };
+        threads.emplace_back(run_bench_client, &states[i]);
+    }
+    for (thread& t : threads) t.join();
+
+    double wall_sec = chrono::duration<double>(
+                          chrono::steady_clock::now() - start)
+                          .count();
+
+    uint64_t latency_us = 0, batch = 0;
+
+    for (const BenchClient& state : states) {
+        if (!state.ok) {
+            fprintf(stderr, "a client lost its connection to %s\n", path);
+            return 1;
+        }
+        latency_us += state.latency_us;
+        batch      += state.batch;
+    }
+
+    double requests = (double)clients * rounds * pipeline;
+
+    printf("requests:     %.0f (%.0f per second)\n",
+           requests,
+           requests / wall_sec);
+    printf("round trip:   %.1f us mean for %d requests\n",
+           (double)latency_us / ((double)clients * rounds),
+           pipeline);
+    printf("mean batch:   %.1f\n", (double)batch / requests);
+
+    return 0;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s serve --socket PATH [--weights FILE]\n"
+            "           [--batch N] [--wait-us U] [--max-clients C]\n"
+            "       %s bench --socket PATH [--clients C]\n"
+            "           [--rounds R] [--pipeline P]\n",
+            program,
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool serving             = strcmp(argv[1], "serve") == 0;
+    const char* path         = NULL;
+    const char* weights_path = NULL;
+    int clients              = 8;
+    int rounds               = 1000;
+    int pipeline             = 16;
+    ServerConfig config;
+    init_server_config(&config);
+
+    if (!serving && strcmp(argv[1], "bench") != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--socket") == 0 && has_value) {
+            path = argv[++i];
+        } else if (serving && strcmp(argv[i], "--weights") == 0 &&
+                   has_value) {
+            weights_path = argv[++i];
+        } else if (serving && strcmp(argv[i], "--batch") == 0 &&
+                   has_value) {
+            config.max_batch = atoi(argv[++i]);
+        } else if (serving && strcmp(argv[i], "--wait-us") == 0 &&
+                   has_value) {
+            config.batch_wait_us = strtoull(argv[++i], NULL, 10);
+        } else if (serving && strcmp(argv[i], "--max-clients") == 0 &&
+                   has_value) {
+            config.max_clients = atoi(argv[++i]);
+        } else if (!serving && strcmp(argv[i], "--clients") == 0 &&
+                   has_value) {
+            clients = atoi(argv[++i]);
+        } else if (!serving && strcmp(argv[i], "--rounds") == 0 &&
+                   has_value) {
+            rounds = atoi(argv[++i]);
+        } else if (!serving && strcmp(argv[i], "--pipeline") == 0 &&
+                   has_value) {
+            pipeline = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path || config.max_batch <= 0 || config.max_clients <= 0 ||
+        clients <= 0 || rounds <= 0 || pipeline <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    return serving ? serve(path, weights_path, &config) :
+                     bench(path, clients, rounds, pipeline);
+}
@@ -0,0 +1,139 @@
+#include "shader.h"
+
+#include <SDL_log.h>
+
+using namespace std;
+
+static void list_variables(GLuint program,
+                           GLenum count_query,
+                           GLenum length_query,
+                           bool attributes,
+                           vector<ShaderVariable>& out) {
+    GLint count = 0, max_length = 0;
+
+    glGetProgramiv(program, count_query, &count);
+    glGetProgramiv(program, length_query, &max_length);
+
+    vector<GLchar> name(max_length + 1);
+
+    out.clear();
+
+    for (GLint i = 0; i < count; i++) {
+        ShaderVariable variable;
+        GLsizei length = 0;
+
+        if (attributes) {
+            glGetActiveAttrib(program,
+                              (GLuint)i,
+                              (GLsizei)name.size(),
+                              &length,
+                              &variable.size,
+                              &variable.type,
+                              name.data());
+        } else {
+            glGetActiveUniform(program,
+                               (GLuint)i,
+                               (GLsizei)name.size(),
+                               &length,
+                               &variable.size,
+                               &variable.type,
+                               name.data());
+        }
+
+        variable.name.assign(name.data(), length);
+
+        // Built-ins such as gl_VertexID have no location.
+        if (variable.name.compare(0, 3, "gl_") == 0) continue;
+
+        variable.location =
+            attributes ? glGetAttribLocation(program, variable.name.c_str()) :
+                         glGetUniformLocation(program, variable.name.c_str());
+
+        size_t bracket = variable.name.find('[');
+        if (bracket != string::npos) variable.name.resize(bracket);
+
+        out.push_back(variable);
+    }
+}
+
+static const ShaderVariable* find_variable(
+    const vector<ShaderVariable>& variables,
+    const char* name) {
+    for (const ShaderVariable& variable : variables) {
+        if (variable.name == name) return &variable;
+    }
+    return NULL;
+}
+
+/*
+ * Location of the uniform called name if it has the expected type,
+ * otherwise -1.
+ */
+static GLint resolve(const Shader* shader, const char* name, GLenum type) {
+    const ShaderVariable* uniform = shader_uniform(shader, name);
+
+    if (!uniform) return -1;
+
+    if (uniform->type != type) {
+        SDL_Log("Uniform \'%s\' of program %d has type 0x%x, expected "
+                "0x%x.\n",
+                name,
+                shader->program,
+                uniform->type,
+                type);
+        return -1;
+    }
+
+    return uniform->location;
+}
+
+void shader_reflect(Shader* shader) {
+    list_variables(shader->program,
+                   GL_ACTIVE_UNIFORMS,
+                   GL_ACTIVE_UNIFORM_MAX_LENGTH,
+                   false,
+                   shader->uniforms);
+    list_variables(shader->program,
+                   GL_ACTIVE_ATTRIBUTES,
+                   GL_ACTIVE_ATTRIBUTE_MAX_LENGTH,
+                   true,
+                   shader->attributes);
+
+    shader->projection.location =
+        resolve(shader, "projection", GL_FLOAT_MAT4);
+    shader->image.location =
+        resolve(shader, "image", GL_SAMPLER_2D);
+
+    SDL_Log("Program %d has %d active uniforms and %d attributes.\n",
+            shader->program,
+            (int)shader->uniforms.size(),
+            (int)shader->attributes.size());
+}
+
+const ShaderVariable* shader_uniform(const Shader* shader, const char* name) {
+    return find_variable(shader->uniforms, name);
+}
+
+const ShaderVariable* shader_attribute(const Shader* shader,
+                                       const char* name) {
+    return find_variable(shader->attributes, name);
+}
+
+void destroy_shader(Shader* shader) {
+    glDeleteProgram(shader->program);
+
+    shader->program = 0;
+    shader->uniforms.clear();
+    shader->attributes.clear();
+}
+
+void set_uniform(GLuint program, UniformMat4 uniform, Mat4x4 value) {
+    if (uniform.location < 0) return;
+    glProgramUniformMatrix4fv(
+        program, uniform.location, 1, GL_TRUE, value[0]);
+}
+
+void set_uniform(GLuint program, UniformSampler uniform, GLint unit) {
+    if (uniform.location < 0) return;
+    glProgramUniform1i(program, uniform.location, unit);
+}
@@ -0,0 +1,78 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include "math.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL_opengl.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Uniform locations by the type of value they take, -1 when the
+ * program has no such uniform. Setting a -1 location is a no-op.
+ */
+struct UniformMat4 {
+    GLint location;
+};
+
+struct UniformSampler {
+    GLint location;
+};
+
+/*
+ * An active uniform or vertex attribute, as the linker reported it.
+ */
+struct ShaderVariable {
+    std::string name; // without the "[0]" of arrays.
+    GLint location;
+    GLenum type;
+    GLint size; // array length, 1 for plain variables.
+};
+
+/*
+ * A linked program and what it reads. create_shader_program fills it
+ * in once at link time, so drawing never asks the driver for a
+ * location or hashes a name.
+ */
+struct Shader {
+    GLuint program;
+    std::vector<ShaderVariable> uniforms;
+    std::vector<ShaderVariable> attributes;
+
+    // The uniforms the game sets, by the names its shaders use.
+    UniformMat4 projection;
+    UniformSampler image;
+};
+
+/*
+ * Lists the active uniforms and attributes of shader->program and
+ * resolves the typed handles. A handle whose uniform is missing or of
+ * another type is left at -1, the latter with a log line.
+ */
+void shader_reflect(Shader* shader);
+
+/*
+ * The active uniform or attribute called name, NULL if there is none.
+ * For setup code, it is a linear search.
+ */
+const ShaderVariable* shader_uniform(const Shader* shader, const char* name);
+
+const ShaderVariable* shader_attribute(const Shader* shader,
+                                       const char* name);
+
+void destroy_shader(Shader* shader);
+
+/*
+ * Set a uniform of the given program without binding it. Matrices are
+ * row major, like Mat4x4.
+ */
+void set_uniform(GLuint program, UniformMat4 uniform, Mat4x4 value);
+
+/*
+ * Points a sampler at a texture unit.
+ */
+void set_uniform(GLuint program, UniformSampler uniform, GLint unit);
+
+#endif // !SHADER_H
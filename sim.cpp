@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ai.h"
+#include "board.h"
+#include "dataset.h"
+#include "heuristic.h"
+#include "montecarlo.h"
+#include "ntuple.h"
+#include "ntuple_quant.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include "ttable.h"
+
+using namespace std;
+
+enum Player { PLAYER_EXPECTIMAX, PLAYER_MONTE_CARLO };
+
+struct SimConfig {
+    int games;
+    uint64_t seed;
+    int threads;
+    size_t tt_mb;
+    bool tt_canonical;
+    Player player;
+    SearchConfig search;
+    McConfig mc;
+
+    // Expectimax evaluates with this network when set, and --train
+    // trains it instead of playing.
+    const char* weights_path;
+    bool train;
+    TrainConfig training;
+
+    // Replaces the default heuristic weights when set.
+    bool custom_heuristic;
+    HeuristicWeights heuristic;
+
+    // Every position played is recorded here when set.
+    const char* dataset_path;
+    DatasetWriter* dataset;
+};
+
+struct GameRecord {
+    uint64_t game; // index, and generator stream of the seed.
+    uint32_t score;
+    int max_tile;
+    int moves;
+    uint64_t nodes;
+    uint64_t search_us;
+};
+
+struct GameTask {
+    const SimConfig* config;
+    GameRecord record;
+};
+
+/*
+ * Plays one game to the end with the AI picking every move.
+ */
+static void play_game(void* arg) {
+    GameTask* task          = (GameTask*)arg;
+    const SimConfig* config = task->config;
+    GameRecord* record      = &task->record;
+    SearchConfig search     = config->search;
+    McConfig mc             = config->mc;
+    TransTable table;
+
+    if (config->tt_mb > 0) {
+        init_trans_table(&table, config->tt_mb);
+        table.canonical = config->tt_canonical;
+        search.tt       = &table;
+    }
+
+    Rng rng;
+    init_rng_stream(&rng, config->seed, record->game);
+
+    Board board = board_spawn(0, rng_next32(&rng));
+    board       = board_spawn(board, rng_next32(&rng));
+
+    // The final score is only known at the end, so a game's records
+    // are kept until then.
+    vector<DatasetRecord> positions;
+
+    record->score     = 0;
+    record->moves     = 0;
+    record->nodes     = 0;
+    record->search_us = 0;
+
+    while (!board_is_game_over(board)) {
+        Direction best;
+        float value;
+
+        if (config->player == PLAYER_MONTE_CARLO) {
+            McResult result;
+            mc.seed = rng_next(&rng);
+            mc_search(board, &mc, &result);
+
+            best              = result.best;
+            value             = result.value[best];
+            record->nodes     += result.rollouts;
+            record->search_us += result.elapsed_us;
+        } else {
+            SearchResult result;
+            ai_search(board, &search, &result);
+
+            best              = result.best;
+            value             = result.value;
+            record->nodes     += result.nodes;
+            record->search_us += result.elapsed_us;
+        }
+
+        if (best == DIR_COUNT) break;
+
+        if (config->dataset) {
+            DatasetRecord position;
+
+            position.board       = board;
+            position.value       = value;
+            position.final_score = 0;
+            position.game        = (uint32_t)record->game;
+            position.ply         = (uint16_t)record->moves;
+            position.move        = (uint8_t)best;
+            position.reserved    = 0;
+
+            positions.push_back(position);
+        }
+
+        record->moves++;
+
+        board = board_move(board, best, &record->score);
+        board = board_spawn(board, rng_next32(&rng));
+    }
+
+    record->max_tile = board_max_tile(board);
+
+    if (config->dataset) {
+        for (DatasetRecord& position : positions) {
+            position.final_score = record->score;
+        }
+        dataset_append(config->dataset, positions.data(), positions.size());
+    }
+
+    if (config->tt_mb > 0) destroy_trans_table(&table);
+}
+
+static void print_summary(const SimConfig* config,
+                          const vector<GameTask>& tasks,
+                          double wall_sec) {
+    uint64_t total_score = 0, total_moves = 0, total_nodes = 0;
+    uint64_t total_us = 0;
+    uint32_t best     = 0;
+    int reached[16]   = { 0 };
+
+    for (const GameTask& task : tasks) {
+        const GameRecord& r = task.record;
+
+        total_score += r.score;
+        total_moves += r.moves;
+        total_nodes += r.nodes;
+        total_us    += r.search_us;
+        if (r.score > best) best = r.score;
+
+        for (int tile = 1; tile <= r.max_tile; tile++) reached[tile]++;
+    }
+
+    size_t games = tasks.size();
+
+    printf("games:        %zu\n", games);
+    printf("mean score:   %.1f\n", (double)total_score / games);
+    printf("best score:   %u\n", best);
+    printf("moves:        %llu (%.1f moves/s wall)\n",
+           (unsigned long long)total_moves,
+           (double)total_moves / wall_sec);
+    printf("%-14s%.0f per search thread\n",
+           config->player == PLAYER_MONTE_CARLO ? "rollouts/s:" :
+                                                  "nodes/s:",
+           total_us > 0 ? (double)total_nodes * 1e6 / total_us : 0.0);
+    printf("wall time:    %.2f s\n", wall_sec);
+
+    for (int tile = 9; tile < 16; tile++) {
+        if (reached[tile] == 0) continue;
+        printf("reached %5d: %5.1f%%\n",
+               1 << tile,
+               100.0 * reached[tile] / games);
+    }
+}
+
+// Games per training round, each round reports and checkpoints.
+const int TRAIN_ROUND_GAMES = 1000;
+
+/*
+ * Trains the network at config->weights_path, resuming from it when it
+ * exists, and writes it back after every round.
+ */
+static int train(SimConfig* config, ThreadPool* pool) {
+    NTupleNetwork network;
+
+    if (ntuple_load(&network, config->weights_path)) {
+        printf("resuming from %s\n", config->weights_path);
+    } else if (!init_ntuple_network(&network, NTUPLE_PATTERNS_6X4, 4)) {
+        fprintf(stderr, "could not allocate the network\n");
+        return 1;
+    }
+
+    TrainConfig training = config->training;
+    training.pool        = pool;
+
+    for (int done = 0; done < config->games;) {
+        TrainStats stats;
+
+        training.games = min(TRAIN_ROUND_GAMES, config->games - done);
+        training.seed  = config->seed + done;
+        ntuple_train(&network, &training, &stats);
+        done += training.games;
+
+        printf("games %7d  mean %8.1f  best %6u  2048 %5.1f%%  "
+               "%.1f games/s\n",
+               done,
+               stats.mean_score,
+               stats.best_score,
+               100.0 * stats.reached[11] / stats.games,
+               stats.games_per_sec);
+
+        if (!ntuple_save(&network, config->weights_path)) {
+            fprintf(stderr, "could not write %s\n", config->weights_path);
+            destroy_ntuple_network(&network);
+            return 1;
+        }
+    }
+
+    destroy_ntuple_network(&network);
+
+    return 0;
+}
+
+/*
+ * Checks every block checksum of a dataset written by --dataset.
+ */
+static int verify_dataset(const char* path) {
+    DatasetStats stats;
+    bool ok = dataset_verify(path, &stats);
+
+    printf("records:      %llu\n", (unsigned long long)stats.records);
+    printf("blocks:       %llu (%llu bad)\n",
+           (unsigned long long)stats.blocks,
+           (unsigned long long)stats.bad_blocks);
+    printf("games:        %llu\n", (unsigned long long)stats.games);
+
+    if (!ok) fprintf(stderr, "%s is damaged or not a dataset\n", path);
+
+    return ok ? 0 : 1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--games N] [--seed S] [--threads T]\n"
+            "    [--player expectimax|mc]\n"
+            "    [--depth D] [--budget-us U] [--iterative]\n"
+            "    [--tt-mb M] [--tt-canonical]\n"
+            "    [--rollouts K] [--rollout-policy random|greedy]\n"
+            "    [--weights FILE] [--train] [--alpha A] [--lambda L]\n"
+            "    [--heuristic name=value,...]\n"
+            "    [--dataset FILE]\n"
+            "       %s --verify FILE\n",
+            program,
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    SimConfig config;
+    config.games        = 10;
+    config.seed         = 1;
+    config.threads      = 0;
+    config.tt_mb        = 16;
+    config.tt_canonical = false;
+    config.player       = PLAYER_EXPECTIMAX;
+    init_search_config(&config.search);
+    init_mc_config(&config.mc);
+    config.weights_path = NULL;
+    config.train        = false;
+    init_train_config(&config.training);
+    config.custom_heuristic = false;
+    init_heuristic_weights(&config.heuristic);
+    config.dataset_path = NULL;
+    config.dataset      = NULL;
+
+    if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+        return verify_dataset(argv[2]);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--games") == 0 && has_value) {
+            config.games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--depth") == 0 && has_value) {
+            config.search.max_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--budget-us") == 0 && has_value) {
+            config.search.budget_us = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--iterative") == 0) {
+            config.search.iterative = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tt-mb") == 0 && has_value) {
+            config.tt_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tt-canonical") == 0) {
+            config.tt_canonical = true;
+        } else if (strcmp(argv[i], "--player") == 0 && has_value) {
+            i++;
+            if (strcmp(argv[i], "mc") == 0) {
+                config.player = PLAYER_MONTE_CARLO;
+            } else if (strcmp(argv[i], "expectimax") == 0) {
+                config.player = PLAYER_EXPECTIMAX;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--rollouts") == 0 && has_value) {
+            config.mc.rollouts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rollout-policy") == 0 &&
+                   has_value) {
+            i++;
+            if (strcmp(argv[i], "greedy") == 0) {
+                config.mc.policy = ROLLOUT_GREEDY;
+            } else if (strcmp(argv[i], "random") == 0) {
+                config.mc.policy = ROLLOUT_RANDOM;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--weights") == 0 && has_value) {
+            config.weights_path = argv[++i];
+        } else if (strcmp(argv[i], "--train") == 0) {
+            config.train = true;
+        } else if (strcmp(argv[i], "--alpha") == 0 && has_value) {
+            config.training.alpha = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--lambda") == 0 && has_value) {
+            config.training.lambda = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dataset") == 0 && has_value) {
+            config.dataset_path = argv[++i];
+        } else if (strcmp(argv[i], "--heuristic") == 0 && has_value) {
+            config.custom_heuristic = true;
+            if (!heuristic_parse_weights(argv[++i], &config.heuristic)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.train && !config.weights_path) ||
+        (config.train && config.dataset_path) ||
+        (config.custom_heuristic && config.weights_path)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (config.games <= 0 || config.search.max_depth <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    init_board_tables();
+
+    // --weights takes float or quantized checkpoints.
+    NTupleNetwork network;
+    QuantNetwork quant;
+    bool has_network = false, has_quant = false;
+
+    if (config.weights_path && !config.train) {
+        if (quant_load(&quant, config.weights_path)) {
+            has_quant                 = true;
+            config.search.eval        = { &evaluate_quant, &quant };
+            config.search.add_rewards = true;
+        } else if (ntuple_load(&network, config.weights_path)) {
+            has_network               = true;
+            config.search.eval        = { &evaluate_ntuple, &network };
+            config.search.add_rewards = true;
+        } else {
+            fprintf(stderr, "could not load %s\n", config.weights_path);
+            return 1;
+        }
+    }
+
+    // Games are independent, so each one is a task and every search
+    // stays single threaded. Game i always draws from stream i of the
+    // seed, whatever thread it lands on.
+    ThreadPool pool;
+    init_thread_pool(&pool, config.threads);
+    int threads = thread_pool_size(&pool);
+
+    Heuristic heuristic;
+
+    if (config.custom_heuristic) {
+        init_heuristic(&heuristic, &config.heuristic, &pool);
+        config.search.eval = { &evaluate_heuristic, &heuristic };
+    }
+
+    if (config.train) {
+        int status = train(&config, &pool);
+        destroy_thread_pool(&pool);
+        return status;
+    }
+
+    DatasetWriter dataset;
+
+    if (config.dataset_path) {
+        if (!init_dataset_writer(&dataset, config.dataset_path)) {
+            fprintf(stderr, "could not create %s\n", config.dataset_path);
+            destroy_thread_pool(&pool);
+            return 1;
+        }
+        config.dataset = &dataset;
+    }
+
+    vector<GameTask> tasks(config.games);
+    TaskGroup group;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < config.games; i++) {
+        tasks[i].config      = &config;
+        tasks[i].record.game = (uint64_t)i;
+        thread_pool_submit(&pool, &group, &play_game, &tasks[i]);
+    }
+    thread_pool_wait(&pool, &group);
+
+    double wall_sec = chrono::duration<double>(
+                          chrono::steady_clock::now() - start)
+                          .count();
+
+    destroy_thread_pool(&pool);
+    if (has_network) destroy_ntuple_network(&network);
+    if (has_quant) destroy_quant_network(&quant);
+    if (config.custom_heuristic) destroy_heuristic(&heuristic);
+
+    printf("threads:      %d\n", threads);
+    print_summary(&config, tasks, wall_sec);
+
+    if (config.dataset) {
+        if (!destroy_dataset_writer(&dataset)) {
+            fprintf(stderr, "could not write %s\n", config.dataset_path);
+            return 1;
+        }
+        printf("dataset:      %llu records in %llu blocks\n",
+               (unsigned long long)dataset.records,
+               (unsigned long long)dataset.blocks);
+    }
+
+    return 0;
+}
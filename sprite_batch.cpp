@@ -0,0 +1,121 @@
+#include "sprite_batch.h"
+
+#include <cstddef>
+
+
+static void set_instance_attrib(GLuint index, int size, size_t offset) {
+    glEnableVertexAttribArray(index);
+    glVertexAttribPointer(index,
+                          size,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(SpriteInstance),
+                          (void*)offset);
+    glVertexAttribDivisor(index, 1);
+}
+
+bool init_sprite_batch(SpriteBatch* batch,
+                       GLuint quad_vbo,
+                       size_t capacity) {
+    if (!init_stream_buffer(&batch->stream,
+                            capacity * sizeof(SpriteInstance))) {
+        return false;
+    }
+
+    glGenVertexArrays(1, &batch->vao);
+    glBindVertexArray(batch->vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(
+        0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+    // Over the whole buffer, a draw selects its region by base instance.
+    glBindBuffer(GL_ARRAY_BUFFER, batch->stream.buffer);
+    set_instance_attrib(1, 4, offsetof(SpriteInstance, rect));
+    set_instance_attrib(2, 4, offsetof(SpriteInstance, uv));
+    set_instance_attrib(3, 4, offsetof(SpriteInstance, tint));
+    set_instance_attrib(4, 1, offsetof(SpriteInstance, rotation));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    batch->draw_calls = 0;
+
+    return true;
+}
+
+void destroy_sprite_batch(SpriteBatch* batch) {
+    destroy_stream_buffer(&batch->stream);
+    glDeleteVertexArrays(1, &batch->vao);
+
+    batch->runs.clear();
+}
+
+void sprite_batch_add(SpriteBatch* batch,
+                      GLuint program,
+                      GLuint texture,
+                      Vec2 position,
+                      Vec2 size,
+                      float rotation,
+                      Vec4 uv,
+                      Vec4 tint) {
+    size_t offset;
+    void* memory = stream_buffer_alloc(&batch->stream,
+                                       sizeof(SpriteInstance),
+                                       sizeof(SpriteInstance),
+                                       &offset);
+
+    // The region is full, draw it and go on in the next one.
+    if (!memory) {
+        sprite_batch_flush(batch);
+        memory = stream_buffer_alloc(&batch->stream,
+                                     sizeof(SpriteInstance),
+                                     sizeof(SpriteInstance),
+                                     &offset);
+    }
+
+    SpriteInstance* instance = (SpriteInstance*)memory;
+
+    instance->rect     = { position.x, position.y, size.x, size.y };
+    instance->uv       = uv;
+    instance->tint     = tint;
+    instance->rotation = rotation;
+    instance->pad[0]   = instance->pad[1] = instance->pad[2] = 0.0f;
+
+    GLuint index = (GLuint)(offset / sizeof(SpriteInstance));
+
+    if (!batch->runs.empty() && batch->runs.back().program == program &&
+        batch->runs.back().texture == texture) {
+        batch->runs.back().count++;
+    } else {
+        batch->runs.push_back({ program, texture, index, 1 });
+    }
+}
+
+void sprite_batch_flush(SpriteBatch* batch) {
+    batch->draw_calls = 0;
+
+    if (batch->runs.empty()) return;
+
+    glBindVertexArray(batch->vao);
+
+    GLuint program = 0, texture = 0;
+
+    for (const SpriteRun& run : batch->runs) {
+        if (run.program != program) glUseProgram(run.program);
+        if (run.texture != texture) glBindTextureUnit(0, run.texture);
+
+        program = run.program;
+        texture = run.texture;
+
+        glDrawArraysInstancedBaseInstance(
+            GL_TRIANGLES, 0, 6, run.count, run.first);
+        batch->draw_calls++;
+    }
+
+    glBindVertexArray(0);
+
+    stream_buffer_fence(&batch->stream);
+    batch->runs.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "math.h"
+#include "stream_buffer.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL_opengl.h>
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * One sprite as the batch vertex shader reads it, one instance each.
+ */
+struct SpriteInstance {
+    Vec4 rect;      // position.x, position.y, size.x, size.y
+    Vec4 uv;        // u0, v0, u1, v1 within the texture.
+    Vec4 tint;      // multiplies the texel, alpha included.
+    float rotation; // radians about the sprite center.
+    float pad[3];
+};
+
+/*
+ * Consecutive sprites sharing a program and a texture.
+ */
+struct SpriteRun {
+    GLuint program;
+    GLuint texture;
+    GLuint first; // base instance.
+    GLsizei count;
+};
+
+/*
+ * Collects the sprites of a frame and draws them with one instanced
+ * draw per run of sprites sharing a material (program and texture).
+ *
+ * Sprites are drawn in the order they were added, so runs only merge
+ * neighbours: interleaving materials costs a draw per switch.
+ * Instances are written straight into a persistently mapped stream
+ * buffer, one region per flush, and draws pick them up by base
+ * instance.
+ */
+struct SpriteBatch {
+    GLuint vao;
+    StreamBuffer stream;
+    std::vector<SpriteRun> runs;
+    int draw_calls; // of the last flush.
+};
+
+/*
+ * quad_vbo holds the 6 vertices of the unit quad, vec4 position and
+ * texture coordinates, bound to attribute 0 like the sprite VAO.
+ * capacity is the number of sprites a flush holds; adding more than
+ * that flushes early. Returns false when the stream buffer cannot be
+ * mapped.
+ */
+bool init_sprite_batch(SpriteBatch* batch,
+                       GLuint quad_vbo,
+                       size_t capacity);
+
+void destroy_sprite_batch(SpriteBatch* batch);
+
+void sprite_batch_add(SpriteBatch* batch,
+                      GLuint program,
+                      GLuint texture,
+                      Vec2 position,
+                      Vec2 size,
+                      float rotation,
+                      Vec4 uv,
+                      Vec4 tint);
+
+/*
+ * Draws and forgets every sprite added since the last flush, then
+ * fences their region of the stream buffer. Leaves the last run's
+ * program and texture bound.
+ */
+void sprite_batch_flush(SpriteBatch* batch);
+
+#endif // !SPRITE_BATCH_H
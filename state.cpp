@@ -2,41 +2,34 @@
 #include "SDL_events.h"
 #include "SDL_timer.h"
 
+#include <cmath>
+
+#include "hint.h"
 #include "math.h"
 #include "renderer.h"
 
+static const char* direction_names[DIR_COUNT] = { "up",
+                                                  "down",
+                                                  "left",
+                                                  "right" };
 
-void intro_state_init(IntroState* state, Game* game, Renderer* renderer) {
-    state->ticks = 0.0f;
 
-    Mat4x4 projection;
-
-    mat4x4_ortho(projection,
-                 0.0f,
-                 (float)game->win_width,
-                 (float)game->win_height,
-                 (float)0.0f,
-                 0.0f,
-                 100.0f);
-    // setup projection matrix...
-    use_shader(renderer, "blink");
-
-    glUniformMatrix4fv(glGetUniformLocation(renderer->shaders["blink"],
-                                            "projection"),
-                       1,
-                       GL_TRUE,
-                       projection[0]);
-    glUniform1i(
-        glGetUniformLocation(renderer->shaders["blink"], "image"), 0);
+void intro_state_init(IntroState* state) {
+    state->ticks = 0.0f;
 }
 
 void intro_state_handle_input(Game* game, SDL_Event* event) {
     switch ((*event).type) {
         case SDL_QUIT: game->running = false; break;
 
-        case SDL_KEYUP:
-            SDL_Log("Key pressed up!\n");
+        case SDL_KEYUP: {
+            GamePlayState play;
+            game_play_state_init(&play, game);
+
+            State state = { .game_play = play };
+            game->states.push(state);
             break;
+        }
 
         default: break;
     }
@@ -48,37 +41,104 @@ void intro_state_update(IntroState* state) {
 }
 
 void intro_state_render(IntroState* state, Game* game, Renderer* renderer) {
-    // use program blinking sprite.
-    use_shader(renderer, "sprite");
-
-    glUniform1f(glGetUniformLocation(
-                    renderer->shaders["sprite"], "time"),
-                (float)state->ticks);
-
-    // render the textured quad...
-    render_sprite(game,
-                  "bg",
-                  renderer,
-                  "sprite",
-                  { 0.0f, 0.0f },
-                  { (float)game->win_width, (float)game->win_height },
-                  0,
-                  { 0, 0, 0 });
-
-    use_shader(renderer, "blink");
-
-
-    // set the uniform 'time'.
-    glUniform1f(
-        glGetUniformLocation(renderer->shaders["blink"], "time"),
-        state->ticks);
-
-    render_sprite(game,
-                  "press",
-                  renderer,
-                  "blink",
-                  { 50, 400 },
-                  { 418, 133 },
-                  0,
-                  { 0, 0, 0 });
+    // The press sprite blinks through its tint alpha; texels that are
+    // already transparent stay so.
+    float blink = fabsf(sinf(0.001f * state->ticks));
+
+    queue_sprite(game,
+                 "bg",
+                 renderer,
+                 SHADER_BATCH,
+                 LAYER_BACKGROUND,
+                 { 0.0f, 0.0f },
+                 { (float)game->win_width, (float)game->win_height },
+                 0,
+                 { 1, 1, 1, 1 });
+
+    queue_sprite(game,
+                 "press",
+                 renderer,
+                 SHADER_BATCH,
+                 LAYER_OVERLAY,
+                 { 50, 400 },
+                 { 418, 133 },
+                 0,
+                 { 1, 1, 1, blink });
+
+    flush_sprites(renderer);
+}
+
+static void post_board(GamePlayState* state, Game* game) {
+    state->hint            = DIR_COUNT;
+    state->hint_depth      = 0;
+    state->hint_generation = hint_post(game->hints, state->board);
+}
+
+void game_play_state_init(GamePlayState* state, Game* game) {
+    state->state_id = GAMEPLAY_STATE;
+    state->score    = 0;
+
+    init_rng(&state->rng, SDL_GetTicks64());
+
+    state->board = board_spawn(0, rng_next32(&state->rng));
+    state->board = board_spawn(state->board, rng_next32(&state->rng));
+
+    post_board(state, game);
+}
+
+void game_play_state_handle_input(GamePlayState* state,
+                                  Game* game,
+                                  SDL_Event* event) {
+    Direction dir = DIR_COUNT;
+
+    switch ((*event).type) {
+        case SDL_QUIT: game->running = false; return;
+
+        case SDL_KEYDOWN:
+            switch (event->key.keysym.sym) {
+                case SDLK_UP: dir = DIR_UP; break;
+                case SDLK_DOWN: dir = DIR_DOWN; break;
+                case SDLK_LEFT: dir = DIR_LEFT; break;
+                case SDLK_RIGHT: dir = DIR_RIGHT; break;
+                // Space plays the hint, once it has arrived.
+                case SDLK_SPACE: dir = state->hint; break;
+                default: break;
+            }
+            break;
+
+        default: break;
+    }
+
+    if (dir == DIR_COUNT) return;
+
+    Board next = board_move(state->board, dir, &state->score);
+
+    if (next == state->board) return;
+
+    state->board = board_spawn(next, rng_next32(&state->rng));
+
+    if (board_is_game_over(state->board)) {
+        SDL_Log("Game over, score %u.\n", state->score);
+    }
+
+    post_board(state, game);
+}
+
+void game_play_state_poll_hints(GamePlayState* state, Game* game) {
+    HintResult result;
+
+    if (!hint_poll(game->hints, &result) ||
+        result.generation != state->hint_generation) {
+        return;
+    }
+
+    state->hint       = result.best;
+    state->hint_depth = result.depth;
+
+    if (result.best != DIR_COUNT) {
+        SDL_Log("Hint: %s (depth %d, %.1f ms).\n",
+                direction_names[result.best],
+                result.depth,
+                result.elapsed_us / 1000.0);
+    }
 }
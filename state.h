@@ -4,6 +4,9 @@
 
 #include "SDL.h"
 
+#include "board.h"
+#include "rng.h"
+
 
 struct Renderer;
 struct Game;
@@ -15,12 +18,31 @@ struct IntroState {
     float ticks;
 };
 
-void intro_state_init(IntroState* state, Game* game, Renderer* renderer);
+void intro_state_init(IntroState* state);
 void intro_state_handle_input(Game* game, SDL_Event* event);
 void intro_state_update(IntroState* state);
 void intro_state_render(IntroState* state, Game* game, Renderer* renderer);
 
-struct GamePlayState {};
+/*
+ * A game on the packed board. Every change of the board posts it to
+ * game->hints, and the main loop feeds the answers back through
+ * game_play_state_poll_hints without ever waiting on a search.
+ */
+struct GamePlayState {
+    States state_id = GAMEPLAY_STATE;
+    Board board;
+    uint32_t score;
+    Rng rng;
+    uint64_t hint_generation; // of the latest posted board.
+    Direction hint;           // DIR_COUNT until it arrives.
+    int hint_depth;
+};
+
+void game_play_state_init(GamePlayState* state, Game* game);
+void game_play_state_handle_input(GamePlayState* state,
+                                  Game* game,
+                                  SDL_Event* event);
+void game_play_state_poll_hints(GamePlayState* state, Game* game);
 
 
 union State {
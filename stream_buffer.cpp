@@ -0,0 +1,97 @@
+#include "stream_buffer.h"
+
+const GLbitfield STREAM_BUFFER_FLAGS =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// How long one glClientWaitSync call may block, in nanoseconds.
+const GLuint64 STREAM_BUFFER_WAIT_NS = 1000000;
+
+/*
+ * Waits until the GPU is done with the region, then drops its fence.
+ */
+static void wait_region(StreamBuffer* stream, int region) {
+    GLsync fence = stream->fences[region];
+
+    if (!fence) return;
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+
+    if (status == GL_TIMEOUT_EXPIRED) {
+        stream->stalls++;
+
+        do {
+            status = glClientWaitSync(fence,
+                                      GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      STREAM_BUFFER_WAIT_NS);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    stream->fences[region] = 0;
+}
+
+bool init_stream_buffer(StreamBuffer* stream, size_t region_size) {
+    GLsizeiptr size = (GLsizeiptr)(region_size * STREAM_BUFFER_REGIONS);
+
+    glCreateBuffers(1, &stream->buffer);
+    glNamedBufferStorage(stream->buffer, size, NULL, STREAM_BUFFER_FLAGS);
+
+    stream->mapped = (unsigned char*)glMapNamedBufferRange(
+        stream->buffer, 0, size, STREAM_BUFFER_FLAGS);
+
+    if (!stream->mapped) {
+        glDeleteBuffers(1, &stream->buffer);
+        stream->buffer = 0;
+        return false;
+    }
+
+    stream->region_size = region_size;
+    stream->region      = 0;
+    stream->offset      = 0;
+    stream->stalls      = 0;
+
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+        stream->fences[i] = 0;
+    }
+
+    return true;
+}
+
+void destroy_stream_buffer(StreamBuffer* stream) {
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+        wait_region(stream, i);
+    }
+
+    glUnmapNamedBuffer(stream->buffer);
+    glDeleteBuffers(1, &stream->buffer);
+
+    stream->buffer = 0;
+    stream->mapped = NULL;
+}
+
+void* stream_buffer_alloc(StreamBuffer* stream,
+                          size_t size,
+                          size_t alignment,
+                          size_t* buffer_offset) {
+    size_t offset = (stream->offset + alignment - 1) / alignment * alignment;
+
+    if (offset + size > stream->region_size) return NULL;
+
+    // The first write since the region was last fenced.
+    if (stream->offset == 0) wait_region(stream, stream->region);
+
+    *buffer_offset = stream->region * stream->region_size + offset;
+    stream->offset = offset + size;
+
+    return stream->mapped + *buffer_offset;
+}
+
+void stream_buffer_fence(StreamBuffer* stream) {
+    if (stream->offset == 0) return;
+
+    stream->fences[stream->region] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    stream->region = (stream->region + 1) % STREAM_BUFFER_REGIONS;
+    stream->offset = 0;
+}
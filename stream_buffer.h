@@ -0,0 +1,62 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL_opengl.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Regions in flight: one written by the CPU while the GPU may still
+// read the two before it.
+const int STREAM_BUFFER_REGIONS = 3;
+
+/*
+ * A buffer for data written every frame, mapped once for its whole
+ * life (glBufferStorage, persistent and coherent) and split into
+ * STREAM_BUFFER_REGIONS regions used in turn.
+ *
+ * Writes go straight into the mapping, with no glBufferSubData copy
+ * and no orphaning. Each region is fenced when its draws are issued,
+ * and is only reused once that fence has signalled. By then the GPU
+ * has normally finished with it, so the CPU does not wait; a wait that
+ * does happen is counted in stalls.
+ */
+struct StreamBuffer {
+    GLuint buffer;
+    size_t region_size; // bytes.
+    int region;         // being written.
+    size_t offset;      // next free byte within the region.
+    unsigned char* mapped;
+    GLsync fences[STREAM_BUFFER_REGIONS];
+    uint64_t stalls; // times a region was still in use by the GPU.
+};
+
+/*
+ * Returns false when the buffer cannot be created or mapped.
+ */
+bool init_stream_buffer(StreamBuffer* stream, size_t region_size);
+
+/*
+ * Waits for the GPU to finish with every region first.
+ */
+void destroy_stream_buffer(StreamBuffer* stream);
+
+/*
+ * Reserves size bytes at an alignment offset of the current region,
+ * waiting for its fence when the region is fresh. Sets buffer_offset
+ * to where the bytes are in the GL buffer. NULL when the region has no
+ * room left: fence it and try again.
+ */
+void* stream_buffer_alloc(StreamBuffer* stream,
+                          size_t size,
+                          size_t alignment,
+                          size_t* buffer_offset);
+
+/*
+ * Fences the current region after the draws reading it and moves on
+ * to the next. Does nothing for a region with nothing written.
+ */
+void stream_buffer_fence(StreamBuffer* stream);
+
+#endif // !STREAM_BUFFER_H
@@ -0,0 +1,79 @@
+#include "./symmetry.h"
+
+// clang-format off
+static const Direction direction_map[SYMMETRY_COUNT][DIR_COUNT] = {
+    { DIR_UP,    DIR_DOWN,  DIR_LEFT,  DIR_RIGHT },
+    { DIR_UP,    DIR_DOWN,  DIR_RIGHT, DIR_LEFT  },
+    { DIR_DOWN,  DIR_UP,    DIR_LEFT,  DIR_RIGHT },
+    { DIR_DOWN,  DIR_UP,    DIR_RIGHT, DIR_LEFT  },
+    { DIR_LEFT,  DIR_RIGHT, DIR_UP,    DIR_DOWN  },
+    { DIR_RIGHT, DIR_LEFT,  DIR_UP,    DIR_DOWN  },
+    { DIR_LEFT,  DIR_RIGHT, DIR_DOWN,  DIR_UP    },
+    { DIR_RIGHT, DIR_LEFT,  DIR_DOWN,  DIR_UP    },
+};
+
+static const int inverse[SYMMETRY_COUNT] = { 0, 1, 2, 3, 4, 6, 5, 7 };
+// clang-format on
+
+static Board mirror_cols(Board b) {
+    return ((b & 0x000F000F000F000FULL) << 12) |
+           ((b & 0x00F000F000F000F0ULL) << 4) |
+           ((b & 0x0F000F000F000F00ULL) >> 4) |
+           ((b & 0xF000F000F000F000ULL) >> 12);
+}
+
+static Board mirror_rows(Board b) {
+    return (b << 48) | ((b & 0x00000000FFFF0000ULL) << 16) |
+           ((b >> 16) & 0x00000000FFFF0000ULL) | (b >> 48);
+}
+
+Board board_symmetry(Board board, int symmetry) {
+    Board b = symmetry >= 4 ? board_transpose(board) : board;
+
+    switch (symmetry & 3) {
+        case 1: return mirror_cols(b);
+        case 2: return mirror_rows(b);
+        case 3: return mirror_rows(mirror_cols(b));
+        default: return b;
+    }
+}
+
+void board_symmetries(Board board, Board out[SYMMETRY_COUNT]) {
+    Board t = board_transpose(board);
+
+    out[0] = board;
+    out[1] = mirror_cols(board);
+    out[2] = mirror_rows(board);
+    out[3] = mirror_rows(out[1]);
+    out[4] = t;
+    out[5] = mirror_cols(t);
+    out[6] = mirror_rows(t);
+    out[7] = mirror_rows(out[5]);
+}
+
+Board board_canonical(Board board, int* symmetry) {
+    Board images[SYMMETRY_COUNT];
+    int best = 0;
+
+    board_symmetries(board, images);
+
+    for (int s = 1; s < SYMMETRY_COUNT; s++) {
+        if (images[s] < images[best]) best = s;
+    }
+
+    if (symmetry) *symmetry = best;
+
+    return images[best];
+}
+
+int symmetry_inverse(int symmetry) {
+    return inverse[symmetry];
+}
+
+Direction symmetry_map_direction(Direction dir, int symmetry) {
+    return direction_map[symmetry][dir];
+}
+
+Direction symmetry_unmap_direction(Direction dir, int symmetry) {
+    return direction_map[inverse[symmetry]][dir];
+}
@@ -0,0 +1,50 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "board.h"
+
+#include <cstdint>
+
+/*
+ * The 8 symmetries of the square, as maps from a board to a board:
+ *
+ *   0 identity          4 transpose (main diagonal)
+ *   1 mirror columns    5 rotate 90 degrees clockwise
+ *   2 mirror rows       6 rotate 90 degrees counter-clockwise
+ *   3 rotate 180        7 anti-transpose
+ *
+ * Every one is a handful of masks and shifts on the packed board,
+ * no per-tile work.
+ */
+const int SYMMETRY_COUNT = 8;
+
+Board board_symmetry(Board board, int symmetry);
+
+/*
+ * All 8 images of board, out[s] being board_symmetry(board, s).
+ */
+void board_symmetries(Board board, Board out[SYMMETRY_COUNT]);
+
+/*
+ * The smallest of the 8 images. Boards that differ only by a rotation
+ * or reflection share it. When symmetry is not NULL it gets the s for
+ * which board_symmetry(board, s) is the canonical board.
+ */
+Board board_canonical(Board board, int* symmetry);
+
+int symmetry_inverse(int symmetry);
+
+/*
+ * The move on board_symmetry(board, symmetry) that matches dir on
+ * board: board_move(board_symmetry(b, s), symmetry_map_direction(d, s))
+ * is board_symmetry(board_move(b, d), s).
+ */
+Direction symmetry_map_direction(Direction dir, int symmetry);
+
+/*
+ * The reverse: takes a move found on the transformed board, e.g. the
+ * canonical one, back to the original board.
+ */
+Direction symmetry_unmap_direction(Direction dir, int symmetry);
+
+#endif // !SYMMETRY_H
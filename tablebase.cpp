@@ -0,0 +1,541 @@
+#include "./tablebase.h"
+#include "./board_n.h"
+#include "./symmetry.h"
+#include "./thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const uint32_t TABLEBASE_MAGIC   = 0x4254384E; // "N8TB"
+const uint32_t TABLEBASE_VERSION = 1;
+
+// Low key bits stored per entry, the rest pick the bucket.
+const int TABLEBASE_KEY_BITS = 16;
+
+// Positions expanded or solved by one pool task.
+const size_t SOLVE_CHUNK = 65536;
+
+struct TablebaseHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t objective;
+    uint32_t target;
+    uint32_t index_bits;
+    uint64_t count;
+    float start_value;
+    uint32_t reserved;
+    uint64_t index_offset;
+    uint64_t keys_offset;
+    uint64_t values_offset;
+    uint64_t moves_offset;
+    uint64_t file_size;
+};
+
+/*
+ * All positions with one tile sum, sorted by canonical key.
+ */
+struct Layer {
+    vector<uint64_t> keys;
+    vector<float> values;
+    vector<uint8_t> moves;
+};
+
+struct SolveChunk {
+    const SolveConfig* config;
+    vector<Layer>* layers; // indexed by tile sum / 2.
+    size_t layer;
+    size_t first;
+    size_t last;
+    vector<uint64_t> spawned[2]; // canonical successors with a 2, a 4.
+};
+
+void init_solve_config(SolveConfig* config) {
+    config->size      = 3;
+    config->objective = SOLVE_SCORE;
+    config->target    = 10;
+    config->pool      = NULL;
+}
+
+template <int N>
+static uint64_t canonical_key(uint64_t word, int* symmetry) {
+    BoardN<N> board = { { word } };
+
+    return board_n_canonical(board, symmetry).words[0];
+}
+
+static int tile_sum(uint64_t word) {
+    int sum = 0;
+
+    for (int i = 0; i < 16; i++) {
+        int tile = (int)((word >> (4 * i)) & 0xF);
+        if (tile) sum += 1 << tile;
+    }
+
+    return sum;
+}
+
+static void sort_unique(vector<uint64_t>* keys) {
+    sort(keys->begin(), keys->end());
+    keys->erase(unique(keys->begin(), keys->end()), keys->end());
+}
+
+template <int N>
+static void expand_chunk(void* arg) {
+    SolveChunk* chunk  = (SolveChunk*)arg;
+    const Layer& layer = (*chunk->layers)[chunk->layer];
+
+    for (size_t i = chunk->first; i < chunk->last; i++) {
+        BoardN<N> board = { { layer.keys[i] } };
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            BoardN<N> next =
+                board_n_move(board, (Direction)dir, (uint32_t*)NULL);
+
+            if (next == board) continue;
+
+            for (int cell = 0; cell < N * N; cell++) {
+                uint64_t word = next.words[0];
+                int shift     = 4 * cell;
+
+                if ((word >> shift) & 0xF) continue;
+
+                chunk->spawned[0].push_back(canonical_key<N>(
+                    word | ((uint64_t)1 << shift), NULL));
+                chunk->spawned[1].push_back(canonical_key<N>(
+                    word | ((uint64_t)2 << shift), NULL));
+            }
+        }
+    }
+
+    sort_unique(&chunk->spawned[0]);
+    sort_unique(&chunk->spawned[1]);
+}
+
+static float layer_value(const vector<Layer>& layers,
+                         size_t layer,
+                         uint64_t key) {
+    if (layer >= layers.size()) return 0.0f;
+
+    const vector<uint64_t>& keys = layers[layer].keys;
+    auto it = lower_bound(keys.begin(), keys.end(), key);
+
+    if (it == keys.end() || *it != key) return 0.0f;
+
+    return layers[layer].values[it - keys.begin()];
+}
+
+template <int N>
+static void solve_chunk(void* arg) {
+    SolveChunk* chunk         = (SolveChunk*)arg;
+    const SolveConfig* config = chunk->config;
+    vector<Layer>& layers     = *chunk->layers;
+    Layer& layer              = layers[chunk->layer];
+
+    for (size_t i = chunk->first; i < chunk->last; i++) {
+        BoardN<N> board   = { { layer.keys[i] } };
+        int best          = DIR_COUNT;
+        double best_value = 0.0;
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            uint32_t gain  = 0;
+            BoardN<N> next = board_n_move(board, (Direction)dir, &gain);
+
+            if (next == board) continue;
+
+            double sum = 0.0;
+            int empty  = 0;
+
+            for (int cell = 0; cell < N * N; cell++) {
+                uint64_t word = next.words[0];
+                int shift     = 4 * cell;
+
+                if ((word >> shift) & 0xF) continue;
+
+                uint64_t two  = canonical_key<N>(
+                    word | ((uint64_t)1 << shift), NULL);
+                uint64_t four = canonical_key<N>(
+                    word | ((uint64_t)2 << shift), NULL);
+
+                sum += 0.9 * layer_value(layers, chunk->layer + 1, two);
+                sum += 0.1 * layer_value(layers, chunk->layer + 2, four);
+                empty++;
+            }
+
+            double value = sum / empty;
+            if (config->objective == SOLVE_SCORE) value += gain;
+
+            if (best == DIR_COUNT || value > best_value) {
+                best       = dir;
+                best_value = value;
+            }
+        }
+
+        if (config->objective == SOLVE_WIN &&
+            board_n_max_tile(board) >= config->target) {
+            best_value = 1.0;
+        }
+
+        layer.values[i] = (float)best_value;
+        layer.moves[i]  = (uint8_t)best;
+    }
+}
+
+/*
+ * Runs fn over the layer in chunks, on the pool when there is one.
+ */
+static void run_chunks(const SolveConfig* config,
+                       vector<Layer>* layers,
+                       size_t layer,
+                       void (*fn)(void*),
+                       vector<SolveChunk>* chunks) {
+    size_t count = (*layers)[layer].keys.size();
+
+    chunks->clear();
+
+    for (size_t first = 0; first < count; first += SOLVE_CHUNK) {
+        SolveChunk chunk;
+
+        chunk.config = config;
+        chunk.layers = layers;
+        chunk.layer  = layer;
+        chunk.first  = first;
+        chunk.last   = min(count, first + SOLVE_CHUNK);
+
+        chunks->push_back(chunk);
+    }
+
+    if (config->pool) {
+        TaskGroup group;
+
+        for (SolveChunk& chunk : *chunks) {
+            thread_pool_submit(config->pool, &group, fn, &chunk);
+        }
+        thread_pool_wait(config->pool, &group);
+    } else {
+        for (SolveChunk& chunk : *chunks) fn(&chunk);
+    }
+}
+
+template <int N>
+static void enumerate_layers(const SolveConfig* config,
+                             vector<Layer>* layers) {
+    vector<vector<uint64_t>> pending;
+    vector<SolveChunk> chunks;
+
+    // A new game is two spawns on the empty board.
+    for (int i = 0; i < N * N; i++) {
+        for (int j = 0; j < N * N; j++) {
+            for (uint64_t a = 1; a <= 2 && i != j; a++) {
+                for (uint64_t b = 1; b <= 2; b++) {
+                    uint64_t word = (a << (4 * i)) | (b << (4 * j));
+                    size_t layer  = tile_sum(word) / 2;
+
+                    if (pending.size() <= layer) pending.resize(layer + 1);
+                    pending[layer].push_back(canonical_key<N>(word, NULL));
+                }
+            }
+        }
+    }
+
+    for (size_t layer = 0; layer < pending.size(); layer++) {
+        layers->resize(layer + 1);
+        sort_unique(&pending[layer]);
+        (*layers)[layer].keys.swap(pending[layer]);
+        vector<uint64_t>().swap(pending[layer]);
+
+        run_chunks(config, layers, layer, &expand_chunk<N>, &chunks);
+
+        if (pending.size() < layer + 3) pending.resize(layer + 3);
+
+        for (SolveChunk& chunk : chunks) {
+            for (int k = 0; k < 2; k++) {
+                vector<uint64_t>& next = pending[layer + 1 + k];
+
+                next.insert(next.end(),
+                            chunk.spawned[k].begin(),
+                            chunk.spawned[k].end());
+            }
+        }
+        sort_unique(&pending[layer + 1]);
+        sort_unique(&pending[layer + 2]);
+
+        while (!pending.empty() && pending.back().empty() &&
+               pending.size() > layer + 1) {
+            pending.pop_back();
+        }
+    }
+}
+
+template <int N>
+static double solve_layers(const SolveConfig* config,
+                           vector<Layer>* layers) {
+    vector<SolveChunk> chunks;
+
+    for (size_t layer = layers->size(); layer-- > 0;) {
+        Layer& l = (*layers)[layer];
+
+        l.values.resize(l.keys.size());
+        l.moves.resize(l.keys.size());
+
+        run_chunks(config, layers, layer, &solve_chunk<N>, &chunks);
+    }
+
+    // Value of a new game: first spawn anywhere, second spawn in any
+    // other cell, each a 2 nine times in ten.
+    double start = 0.0;
+    double cells = N * N;
+
+    for (int i = 0; i < N * N; i++) {
+        for (int j = 0; j < N * N; j++) {
+            for (uint64_t a = 1; a <= 2 && i != j; a++) {
+                for (uint64_t b = 1; b <= 2; b++) {
+                    uint64_t word = (a << (4 * i)) | (b << (4 * j));
+                    double p      = (a == 1 ? 0.9 : 0.1) *
+                               (b == 1 ? 0.9 : 0.1) / (cells * (cells - 1));
+
+                    start += p * layer_value(*layers,
+                                             tile_sum(word) / 2,
+                                             canonical_key<N>(word, NULL));
+                }
+            }
+        }
+    }
+
+    return start;
+}
+
+static uint64_t align64(uint64_t offset) {
+    return (offset + 63) / 64 * 64;
+}
+
+/*
+ * Merges the layers into one sorted table and writes it through a
+ * shared mapping of the output file.
+ */
+static bool write_tablebase(const SolveConfig* config,
+                            const vector<Layer>& layers,
+                            double start_value,
+                            const char* path) {
+    uint64_t count = 0;
+    for (const Layer& layer : layers) count += layer.keys.size();
+
+    int index_bits   = 4 * config->size * config->size - TABLEBASE_KEY_BITS;
+    uint64_t buckets = (uint64_t)1 << index_bits;
+
+    TablebaseHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic         = TABLEBASE_MAGIC;
+    header.version       = TABLEBASE_VERSION;
+    header.size          = (uint32_t)config->size;
+    header.objective     = (uint32_t)config->objective;
+    header.target        = (uint32_t)config->target;
+    header.index_bits    = (uint32_t)index_bits;
+    header.count         = count;
+    header.start_value   = (float)start_value;
+    header.index_offset  = align64(sizeof(header));
+    header.keys_offset   =
+        align64(header.index_offset + (buckets + 1) * sizeof(uint32_t));
+    header.values_offset =
+        align64(header.keys_offset + count * sizeof(uint16_t));
+    header.moves_offset  =
+        align64(header.values_offset + count * sizeof(float));
+    header.file_size     = header.moves_offset + count;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    if (ftruncate(fd, (off_t)header.file_size) != 0) {
+        close(fd);
+        return false;
+    }
+
+    char* map = (char*)mmap(
+        NULL, header.file_size, PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    memcpy(map, &header, sizeof(header));
+
+    uint32_t* index = (uint32_t*)(map + header.index_offset);
+    uint16_t* keys  = (uint16_t*)(map + header.keys_offset);
+    float* values   = (float*)(map + header.values_offset);
+    uint8_t* moves  = (uint8_t*)(map + header.moves_offset);
+
+    // K-way merge: every layer is sorted and keys never repeat across
+    // layers, since the key fixes the tile sum.
+    typedef pair<uint64_t, size_t> Head;
+    priority_queue<Head, vector<Head>, greater<Head>> heads;
+    vector<size_t> next(layers.size(), 0);
+
+    for (size_t l = 0; l < layers.size(); l++) {
+        if (!layers[l].keys.empty()) heads.push({ layers[l].keys[0], l });
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+        Head head = heads.top();
+        heads.pop();
+
+        size_t l   = head.second;
+        size_t pos = next[l]++;
+
+        keys[i]   = (uint16_t)head.first;
+        values[i] = layers[l].values[pos];
+        moves[i]  = layers[l].moves[pos];
+        index[(head.first >> TABLEBASE_KEY_BITS) + 1]++;
+
+        if (next[l] < layers[l].keys.size()) {
+            heads.push({ layers[l].keys[next[l]], l });
+        }
+    }
+
+    for (uint64_t b = 0; b < buckets; b++) index[b + 1] += index[b];
+
+    bool ok = msync(map, header.file_size, MS_SYNC) == 0;
+    munmap(map, header.file_size);
+
+    return ok;
+}
+
+bool solve_tablebase(const SolveConfig* config,
+                     const char* path,
+                     SolveStats* stats) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (config->size != 2 && config->size != 3) return false;
+
+    vector<Layer> layers;
+    double start_value;
+
+    if (config->size == 2) {
+        enumerate_layers<2>(config, &layers);
+        start_value = solve_layers<2>(config, &layers);
+    } else {
+        enumerate_layers<3>(config, &layers);
+        start_value = solve_layers<3>(config, &layers);
+    }
+
+    stats->positions   = 0;
+    stats->layers      = 0;
+    stats->max_tile    = 0;
+    stats->start_value = start_value;
+
+    for (size_t l = 0; l < layers.size(); l++) {
+        if (layers[l].keys.empty()) continue;
+
+        stats->positions += layers[l].keys.size();
+        stats->layers++;
+
+        for (uint64_t key : layers[l].keys) {
+            for (int i = 0; i < 16; i++) {
+                stats->max_tile =
+                    max(stats->max_tile, (int)((key >> (4 * i)) & 0xF));
+            }
+        }
+    }
+
+    bool ok = write_tablebase(config, layers, start_value, path);
+
+    stats->elapsed_us = (uint64_t)chrono::duration_cast<
+                            chrono::microseconds>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+
+    return ok;
+}
+
+bool open_tablebase(Tablebase* tablebase, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(TablebaseHeader)) {
+        close(fd);
+        return false;
+    }
+
+    size_t map_size = (size_t)st.st_size;
+    char* map       = (char*)mmap(
+        NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const TablebaseHeader* header = (const TablebaseHeader*)map;
+
+    bool ok = header->magic == TABLEBASE_MAGIC &&
+              header->version == TABLEBASE_VERSION &&
+              (header->size == 2 || header->size == 3) &&
+              header->index_bits ==
+                  4 * header->size * header->size - TABLEBASE_KEY_BITS &&
+              header->file_size == map_size;
+
+    if (!ok) {
+        munmap(map, map_size);
+        return false;
+    }
+
+    tablebase->size        = (int)header->size;
+    tablebase->objective   = (SolveObjective)header->objective;
+    tablebase->target      = (int)header->target;
+    tablebase->count       = header->count;
+    tablebase->start_value = header->start_value;
+    tablebase->index_bits  = (int)header->index_bits;
+    tablebase->index       = (const uint32_t*)(map + header->index_offset);
+    tablebase->keys        = (const uint16_t*)(map + header->keys_offset);
+    tablebase->values      = (const float*)(map + header->values_offset);
+    tablebase->moves       = (const uint8_t*)(map + header->moves_offset);
+    tablebase->map         = map;
+    tablebase->map_size    = map_size;
+
+    return true;
+}
+
+void close_tablebase(Tablebase* tablebase) {
+    munmap(tablebase->map, tablebase->map_size);
+
+    tablebase->map      = NULL;
+    tablebase->map_size = 0;
+    tablebase->count    = 0;
+}
+
+bool tablebase_probe(const Tablebase* tablebase,
+                     uint64_t board,
+                     Direction* best,
+                     float* value) {
+    int symmetry;
+    uint64_t key = tablebase->size == 2 ?
+        canonical_key<2>(board, &symmetry) :
+        canonical_key<3>(board, &symmetry);
+
+    uint64_t bucket = key >> TABLEBASE_KEY_BITS;
+    if (bucket >> tablebase->index_bits) return false;
+
+    const uint16_t* first = tablebase->keys + tablebase->index[bucket];
+    const uint16_t* last  = tablebase->keys + tablebase->index[bucket + 1];
+    const uint16_t* it    = lower_bound(first, last, (uint16_t)key);
+
+    if (it == last || *it != (uint16_t)key) return false;
+
+    size_t i = it - tablebase->keys;
+
+    *value = tablebase->values[i];
+    *best  = tablebase->moves[i] < DIR_COUNT ?
+        symmetry_unmap_direction((Direction)tablebase->moves[i],
+                                 symmetry) :
+        DIR_COUNT;
+
+    return true;
+}
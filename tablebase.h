@@ -0,0 +1,94 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct ThreadPool;
+
+enum SolveObjective {
+    SOLVE_SCORE, // expected score still to be made.
+    SOLVE_WIN    // probability of reaching the target tile.
+};
+
+struct SolveConfig {
+    int size; // 2 or 3, the board is size x size.
+    SolveObjective objective;
+    int target; // winning tile exponent, for SOLVE_WIN.
+
+    // Layers are split in chunks that run as pool tasks when set.
+    ThreadPool* pool;
+};
+
+struct SolveStats {
+    uint64_t positions;
+    int layers;
+    int max_tile;
+    double start_value; // value of a new game, over its two spawns.
+    uint64_t elapsed_us;
+};
+
+/*
+ * Fills config with the 3x3 board, expected score, target 1024 and
+ * no thread pool.
+ */
+void init_solve_config(SolveConfig* config);
+
+/*
+ * Solves every position reachable from a new game and writes the
+ * tablebase to path.
+ *
+ * Positions are keyed by their canonical board (board_n_canonical),
+ * so symmetric positions are solved and stored once. A move keeps the
+ * sum of the tiles and a spawn adds 2 or 4, so positions fall into
+ * layers by tile sum. Layers are enumerated forwards from the opening
+ * positions, then solved backwards, each from the two layers above.
+ *
+ * The 3x3 board has about 49 million positions up to symmetry, which
+ * takes about a quarter of an hour of one core and 1.1 GB of memory,
+ * and gives a 345 MB tablebase.
+ */
+bool solve_tablebase(const SolveConfig* config,
+                     const char* path,
+                     SolveStats* stats);
+
+/*
+ * A tablebase mapped read-only from its file. The mapping is shared
+ * by every process that opens the same file.
+ *
+ * Canonical keys are sorted. The high bits of a key pick a bucket in
+ * index, the low 16 bits are stored in keys and binary searched
+ * within the bucket.
+ */
+struct Tablebase {
+    int size;
+    SolveObjective objective;
+    int target;
+    uint64_t count;
+    float start_value;
+    int index_bits;
+    const uint32_t* index; // 2^index_bits + 1 bucket starts.
+    const uint16_t* keys;
+    const float* values;
+    const uint8_t* moves; // canonical frame, DIR_COUNT when lost.
+    void* map;
+    size_t map_size;
+};
+
+bool open_tablebase(Tablebase* tablebase, const char* path);
+
+void close_tablebase(Tablebase* tablebase);
+
+/*
+ * Looks up board, the single word of a BoardN of the tablebase's
+ * size. Returns false for an unreachable board. Otherwise sets the
+ * best move, DIR_COUNT when none is legal, and its value.
+ */
+bool tablebase_probe(const Tablebase* tablebase,
+                     uint64_t board,
+                     Direction* best,
+                     float* value);
+
+#endif // !TABLEBASE_H
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "board_n.h"
+#include "rng.h"
+#include "tablebase.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+/*
+ * Builds small-board tablebases and plays from them.
+ *
+ *   solve: enumerates and solves every reachable position, see
+ *          solve_tablebase.
+ *   play:  plays games picking every move from the tablebase. The
+ *          mean result should match the solved value of a new game.
+ */
+
+template <int N>
+static bool play_games(const Tablebase* tablebase,
+                       int games,
+                       uint64_t seed) {
+    Rng rng;
+    init_rng(&rng, seed);
+    double total     = 0.0;
+    uint64_t probes  = 0;
+    double probe_sec = 0.0;
+
+    for (int game = 0; game < games; game++) {
+        BoardN<N> board = {};
+        board           = board_n_spawn(board, rng_next32(&rng));
+        board           = board_n_spawn(board, rng_next32(&rng));
+        uint32_t score  = 0;
+
+        for (;;) {
+            Direction best;
+            float value;
+
+            chrono::steady_clock::time_point start =
+                chrono::steady_clock::now();
+            bool found = tablebase_probe(
+                tablebase, board.words[0], &best, &value);
+            probe_sec += chrono::duration<double>(
+                             chrono::steady_clock::now() - start)
+                             .count();
+            probes++;
+
+            if (!found) {
+                fprintf(stderr, "position missing from the tablebase\n");
+                return false;
+            }
+            if (best == DIR_COUNT) break;
+
+            board = board_n_move(board, best, &score);
+            board = board_n_spawn(board, rng_next32(&rng));
+        }
+
+        if (tablebase->objective == SOLVE_WIN) {
+            total += board_n_max_tile(board) >= tablebase->target;
+        } else {
+            total += score;
+        }
+    }
+
+    printf("games:        %d\n", games);
+    printf("mean result:  %.4f (solved %.4f)\n",
+           total / games,
+           tablebase->start_value);
+    printf("probe time:   %.0f ns\n", 1e9 * probe_sec / probes);
+
+    return true;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s solve --out FILE [--size 2|3]\n"
+            "           [--target EXP] [--threads T]\n"
+            "       %s play --in FILE [--games N] [--seed S]\n",
+            program,
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool solve       = strcmp(argv[1], "solve") == 0;
+    const char* path = NULL;
+    int threads      = 0;
+    int games        = 1000;
+    uint64_t seed    = 1;
+    SolveConfig config;
+    init_solve_config(&config);
+
+    if (!solve && strcmp(argv[1], "play") != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], solve ? "--out" : "--in") == 0 && has_value) {
+            path = argv[++i];
+        } else if (solve && strcmp(argv[i], "--size") == 0 && has_value) {
+            config.size = atoi(argv[++i]);
+        } else if (solve && strcmp(argv[i], "--target") == 0 &&
+                   has_value) {
+            config.objective = SOLVE_WIN;
+            config.target    = atoi(argv[++i]);
+        } else if (solve && strcmp(argv[i], "--threads") == 0 &&
+                   has_value) {
+            threads = atoi(argv[++i]);
+        } else if (!solve && strcmp(argv[i], "--games") == 0 &&
+                   has_value) {
+            games = atoi(argv[++i]);
+        } else if (!solve && strcmp(argv[i], "--seed") == 0 &&
+                   has_value) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path || (config.size != 2 && config.size != 3) || games <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (solve) {
+        ThreadPool pool;
+        init_thread_pool(&pool, threads);
+        config.pool = &pool;
+
+        SolveStats stats;
+        bool ok = solve_tablebase(&config, path, &stats);
+
+        destroy_thread_pool(&pool);
+
+        if (!ok) {
+            fprintf(stderr, "could not write %s\n", path);
+            return 1;
+        }
+
+        printf("positions:    %llu in %d layers\n",
+               (unsigned long long)stats.positions,
+               stats.layers);
+        printf("max tile:     %d\n", 1 << stats.max_tile);
+        printf("new game:     %.4f\n", stats.start_value);
+        printf("time:         %.1f s\n", stats.elapsed_us / 1e6);
+
+        return 0;
+    }
+
+    Tablebase tablebase;
+
+    if (!open_tablebase(&tablebase, path)) {
+        fprintf(stderr, "could not open %s\n", path);
+        return 1;
+    }
+
+    bool ok = tablebase.size == 2 ?
+        play_games<2>(&tablebase, games, seed) :
+        play_games<3>(&tablebase, games, seed);
+
+    close_tablebase(&tablebase);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include "./thread_pool.h"
+
+using namespace std;
+
+// Index of the calling thread's queue, -1 outside of the pool.
+static thread_local int worker_index              = -1;
+static thread_local const ThreadPool* worker_pool = NULL;
+
+static bool pop_own(ThreadPool* pool, int index, Task* task) {
+    WorkerQueue* queue = pool->queues[index].get();
+    lock_guard<mutex> guard(queue->lock);
+
+    if (queue->tasks.empty()) return false;
+
+    *task = queue->tasks.back();
+    queue->tasks.pop_back();
+    return true;
+}
+
+static bool steal(ThreadPool* pool, int thief, Task* task) {
+    int count = (int)pool->queues.size();
+    int start = thief < 0 ? 0 : thief + 1;
+
+    for (int i = 0; i < count; i++) {
+        WorkerQueue* queue = pool->queues[(start + i) % count].get();
+        lock_guard<mutex> guard(queue->lock);
+
+        if (queue->tasks.empty()) continue;
+
+        *task = queue->tasks.front();
+        queue->tasks.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+static bool next_task(ThreadPool* pool, Task* task) {
+    int index = worker_pool == pool ? worker_index : -1;
+
+    if (index >= 0 && pop_own(pool, index, task)) return true;
+    return steal(pool, index, task);
+}
+
+static void run_task(ThreadPool* pool, const Task& task) {
+    pool->queued.fetch_sub(1, memory_order_relaxed);
+    task.run(task.arg);
+
+    if (task.group->pending.fetch_sub(1, memory_order_release) == 1) {
+        // Under the lock, so a waiter can't miss it between checking
+        // pending and blocking.
+        lock_guard<mutex> guard(pool->wake_lock);
+        pool->done.notify_all();
+    }
+}
+
+static void worker_main(ThreadPool* pool, int index) {
+    worker_index = index;
+    worker_pool  = pool;
+
+    while (true) {
+        Task task;
+
+        if (next_task(pool, &task)) {
+            run_task(pool, task);
+            continue;
+        }
+
+        unique_lock<mutex> guard(pool->wake_lock);
+        pool->wake.wait(guard, [pool] {
+            return pool->stopping.load() || pool->queued.load() > 0;
+        });
+
+        if (pool->stopping.load()) return;
+    }
+}
+
+void init_thread_pool(ThreadPool* pool, int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = (int)thread::hardware_concurrency();
+        if (thread_count <= 0) thread_count = 1;
+    }
+
+    pool->stopping = false;
+    pool->queued   = 0;
+
+    for (int i = 0; i < thread_count; i++) {
+        pool->queues.push_back(make_unique<WorkerQueue>());
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        pool->threads.emplace_back(worker_main, pool, i);
+    }
+}
+
+void destroy_thread_pool(ThreadPool* pool) {
+    {
+        lock_guard<mutex> guard(pool->wake_lock);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+
+    for (thread& t : pool->threads) t.join();
+
+    pool->threads.clear();
+    pool->queues.clear();
+}
+
+int thread_pool_size(const ThreadPool* pool) {
+    return (int)pool->threads.size();
+}
+
+void thread_pool_submit(ThreadPool* pool,
+                        TaskGroup* group,
+                        void (*run)(void* arg),
+                        void* arg) {
+    int count = (int)pool->queues.size();
+    int index = worker_pool == pool ?
+        worker_index :
+        (int)(pool->next_queue.fetch_add(1, memory_order_relaxed) %
+              (unsigned)count);
+
+    group->pending.fetch_add(1, memory_order_relaxed);
+
+    // Counted before it is pushed, so the worker that pops it can't
+    // take queued below zero. Taking the lock orders the increment
+    // with a thread that is about to check its predicate, so the
+    // wakeup can't be lost.
+    {
+        lock_guard<mutex> guard(pool->wake_lock);
+        pool->queued.fetch_add(1, memory_order_relaxed);
+    }
+
+    {
+        WorkerQueue* queue = pool->queues[index].get();
+        lock_guard<mutex> guard(queue->lock);
+        queue->tasks.push_back({ run, arg, group });
+    }
+
+    pool->wake.notify_one();
+    pool->done.notify_all();
+}
+
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group) {
+    while (group->pending.load(memory_order_acquire) > 0) {
+        Task task;
+
+        if (next_task(pool, &task)) {
+            run_task(pool, task);
+            continue;
+        }
+
+        // Blocks until the group is done, or there is a task to help
+        // with: tasks waiting on subtasks must not starve the pool.
+        unique_lock<mutex> guard(pool->wake_lock);
+        pool->done.wait(guard, [pool, group] {
+            return group->pending.load(memory_order_acquire) == 0 ||
+                   pool->queued.load() > 0;
+        });
+    }
+}
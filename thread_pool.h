@@ -0,0 +1,71 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Task {
+    void (*run)(void* arg);
+    void* arg;
+    struct TaskGroup* group;
+};
+
+/*
+ * Tracks a set of submitted tasks so a caller can wait for just those.
+ */
+struct TaskGroup {
+    std::atomic<int> pending{ 0 };
+};
+
+struct WorkerQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+};
+
+/*
+ * Work-stealing thread pool.
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to the
+ * back of its own deque and are popped LIFO, which keeps recursive
+ * splits cache-friendly. Idle workers steal from the front of the
+ * other deques, taking the oldest and usually largest task.
+ */
+struct ThreadPool {
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<int> queued{ 0 };
+    std::atomic<unsigned> next_queue{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex wake_lock;
+    std::condition_variable wake; // workers, for queued tasks.
+    std::condition_variable done; // waiters, for queued or finished tasks.
+};
+
+/*
+ * Starts thread_count workers, or one per hardware thread when
+ * thread_count is 0.
+ */
+void init_thread_pool(ThreadPool* pool, int thread_count);
+
+void destroy_thread_pool(ThreadPool* pool);
+
+int thread_pool_size(const ThreadPool* pool);
+
+void thread_pool_submit(ThreadPool* pool,
+                        TaskGroup* group,
+                        void (*run)(void* arg),
+                        void* arg);
+
+/*
+ * Blocks until every task of group has finished. The calling thread
+ * runs queued tasks while it waits, so tasks may submit and wait on
+ * groups of their own.
+ */
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group);
+
+#endif // !THREAD_POOL_H
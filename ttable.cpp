@@ -0,0 +1,197 @@
+#include "./ttable.h"
+#include "./symmetry.h"
+
+#include <cstring>
+
+using namespace std;
+
+const uint64_t TT_VALID_BIT = 1ULL << 48;
+
+// How many buckets tt_get_stats looks at to estimate occupancy.
+const size_t TT_STATS_SAMPLE = 4096;
+
+// Depth an entry loses per generation of age when picking a victim.
+const int TT_AGE_PENALTY = 4;
+
+// Victim score of an empty slot, below that of any live entry.
+const int TT_EMPTY_SCORE = -1024;
+
+static uint64_t pack_data(float value, int depth, uint8_t generation) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    return (uint64_t)bits | ((uint64_t)(depth & 0xFF) << 32) |
+           ((uint64_t)generation << 40) | TT_VALID_BIT;
+}
+
+static float data_value(uint64_t data) {
+    uint32_t bits = (uint32_t)data;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static int data_depth(uint64_t data) {
+    return (int)((data >> 32) & 0xFF);
+}
+
+static uint8_t data_generation(uint64_t data) {
+    return (uint8_t)(data >> 40);
+}
+
+/*
+ * The board is already a unique 64-bit key, it only needs its bits
+ * mixed so that similar boards spread over the buckets.
+ */
+static size_t bucket_index(const TransTable* table, Board board) {
+    uint64_t x = board;
+
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+
+    return (size_t)x & (table->bucket_count - 1);
+}
+
+void init_trans_table(TransTable* table, size_t size_mb) {
+    size_t bytes = size_mb * 1024 * 1024;
+    size_t count = 1;
+
+    while (count * 2 * sizeof(TTBucket) <= bytes) count *= 2;
+
+    table->buckets      = new TTBucket[count];
+    table->bucket_count = count;
+    table->canonical    = false;
+
+    tt_clear(table);
+}
+
+void destroy_trans_table(TransTable* table) {
+    delete[] table->buckets;
+
+    table->buckets      = NULL;
+    table->bucket_count = 0;
+}
+
+void tt_clear(TransTable* table) {
+    for (size_t i = 0; i < table->bucket_count; i++) {
+        for (TTEntry& entry : table->buckets[i].entries) {
+            entry.key_xor.store(0, memory_order_relaxed);
+            entry.data.store(0, memory_order_relaxed);
+        }
+    }
+
+    table->generation = 0;
+    table->probes     = 0;
+    table->hits       = 0;
+}
+
+void tt_new_search(TransTable* table) {
+    table->generation.fetch_add(1, memory_order_relaxed);
+}
+
+bool tt_probe(const TransTable* table,
+              Board board,
+              int depth,
+              float* value) {
+    if (table->canonical) board = board_canonical(board, NULL);
+
+    const TTBucket& bucket = table->buckets[bucket_index(table, board)];
+
+    for (const TTEntry& entry : bucket.entries) {
+        uint64_t data = entry.data.load(memory_order_relaxed);
+        uint64_t key  = entry.key_xor.load(memory_order_relaxed) ^ data;
+
+        if (key != board || !(data & TT_VALID_BIT)) continue;
+
+        if (data_depth(data) < depth) return false;
+
+        *value = data_value(data);
+        return true;
+    }
+
+    return false;
+}
+
+void tt_store(TransTable* table, Board board, int depth, float value) {
+    if (table->canonical) board = board_canonical(board, NULL);
+
+    TTBucket& bucket = table->buckets[bucket_index(table, board)];
+    uint8_t generation =
+        table->generation.load(memory_order_relaxed);
+
+    TTEntry* victim  = NULL;
+    int victim_score = 0;
+
+    for (TTEntry& entry : bucket.entries) {
+        uint64_t data = entry.data.load(memory_order_relaxed);
+        uint64_t key  = entry.key_xor.load(memory_order_relaxed) ^ data;
+
+        if (!(data & TT_VALID_BIT)) {
+            if (!victim || victim_score > TT_EMPTY_SCORE) {
+                victim       = &entry;
+                victim_score = TT_EMPTY_SCORE;
+            }
+            continue;
+        }
+
+        if (key == board) {
+            if (depth < data_depth(data)) return;
+            victim = &entry;
+            break;
+        }
+
+        int age   = (uint8_t)(generation - data_generation(data));
+        int score = data_depth(data) - TT_AGE_PENALTY * age;
+
+        if (!victim || score < victim_score) {
+            victim       = &entry;
+            victim_score = score;
+        }
+    }
+
+    uint64_t data = pack_data(value, depth, generation);
+
+    victim->key_xor.store(board ^ data, memory_order_relaxed);
+    victim->data.store(data, memory_order_relaxed);
+}
+
+void tt_record_probes(TransTable* table, uint64_t probes, uint64_t hits) {
+    table->probes.fetch_add(probes, memory_order_relaxed);
+    table->hits.fetch_add(hits, memory_order_relaxed);
+}
+
+void tt_get_stats(const TransTable* table, TTStats* stats) {
+    uint8_t generation =
+        table->generation.load(memory_order_relaxed);
+    size_t sample = table->bucket_count < TT_STATS_SAMPLE ?
+        table->bucket_count :
+        TT_STATS_SAMPLE;
+    size_t step    = table->bucket_count / sample;
+    size_t used    = 0;
+    size_t current = 0;
+
+    for (size_t i = 0; i < sample; i++) {
+        for (const TTEntry& entry : table->buckets[i * step].entries) {
+            uint64_t data = entry.data.load(memory_order_relaxed);
+
+            if (!(data & TT_VALID_BIT)) continue;
+
+            used++;
+            if (data_generation(data) == generation) current++;
+        }
+    }
+
+    stats->probes   = table->probes.load(memory_order_relaxed);
+    stats->hits     = table->hits.load(memory_order_relaxed);
+    stats->hit_rate = stats->probes > 0 ?
+        (double)stats->hits / (double)stats->probes :
+        0.0;
+    stats->occupancy =
+        (double)used / (double)(sample * TT_BUCKET_ENTRIES);
+    stats->current_occupancy =
+        (double)current / (double)(sample * TT_BUCKET_ENTRIES);
+}
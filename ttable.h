@@ -0,0 +1,98 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include "board.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * One cached search value.
+ *
+ * data packs the value bits, the remaining depth, the generation and
+ * a valid flag. key_xor holds the board XOR data, so a reader that
+ * sees the two words from different writes gets a key mismatch and
+ * treats the entry as a miss. That lets threads share the table
+ * without any lock.
+ */
+struct TTEntry {
+    std::atomic<uint64_t> key_xor;
+    std::atomic<uint64_t> data;
+};
+
+const int TT_BUCKET_ENTRIES = 4;
+
+// A bucket fills exactly one cache line, so a probe touches one line.
+struct alignas(64) TTBucket {
+    TTEntry entries[TT_BUCKET_ENTRIES];
+};
+
+struct TransTable {
+    TTBucket* buckets;
+    size_t bucket_count; // power of two.
+    std::atomic<uint8_t> generation;
+    std::atomic<uint64_t> probes;
+    std::atomic<uint64_t> hits;
+
+    // Key entries by board_canonical, so the 8 symmetric images of a
+    // board share one entry. Only correct when the cached values are
+    // symmetric, which they are with a symmetric evaluator.
+    bool canonical;
+};
+
+struct TTStats {
+    uint64_t probes;
+    uint64_t hits;
+    double hit_rate;
+    double occupancy;         // share of entries in use.
+    double current_occupancy; // share written this generation.
+};
+
+/*
+ * Allocates a table of about size_mb megabytes, rounded down to a
+ * power of two buckets, and clears it. canonical starts off.
+ */
+void init_trans_table(TransTable* table, size_t size_mb);
+
+void destroy_trans_table(TransTable* table);
+
+void tt_clear(TransTable* table);
+
+/*
+ * Starts a new generation. Entries from older generations are still
+ * found by tt_probe but are the first to be replaced, so the table
+ * keeps what it learned on the previous moves.
+ */
+void tt_new_search(TransTable* table);
+
+/*
+ * Looks board up. Returns true and sets *value when an entry searched
+ * to at least depth is found.
+ */
+bool tt_probe(const TransTable* table,
+              Board board,
+              int depth,
+              float* value);
+
+/*
+ * Stores a value. An entry for the same board is only overwritten by
+ * an equal or deeper search. Otherwise the bucket gives up an empty
+ * slot, or else the entry with the lowest depth once older
+ * generations are penalized.
+ */
+void tt_store(TransTable* table, Board board, int depth, float value);
+
+/*
+ * Adds a search's probe counters to the table totals. Searches count
+ * locally and report once, so threads don't fight over the counters.
+ */
+void tt_record_probes(TransTable* table, uint64_t probes, uint64_t hits);
+
+/*
+ * Occupancy is estimated from a sample of buckets spread over the
+ * whole table.
+ */
+void tt_get_stats(const TransTable* table, TTStats* stats);
+
+#endif // !TTABLE_H
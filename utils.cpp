@@ -48,7 +48,7 @@ GameError read_whole_file_binary(const char* file_path,
 
 GameError create_shader_program(std::filesystem::path vert_shader_path,
                                 std::filesystem::path frag_shader_path,
-                                GLuint* program) {
+                                Shader* shader) {
     GLuint vs, fs;
     GLint compilation_staus, link_status;
     GLchar compilation_log[512];
@@ -100,18 +100,22 @@ GameError create_shader_program(std::filesystem::path vert_shader_path,
         return GAME_ERROR_FRAG_SHADER_COMPILATION_FAILED;
     }
 
-    *program = glCreateProgram();
+    GLuint program = glCreateProgram();
 
-    glAttachShader(*program, vs);
-    glAttachShader(*program, fs);
-    glLinkProgram(*program);
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
 
-    glGetProgramiv(*program, GL_LINK_STATUS, &link_status);
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
     if (link_status != GL_TRUE) {
-        glGetProgramInfoLog(*program, 512, NULL, compilation_log);
+        glGetProgramInfoLog(program, 512, NULL, compilation_log);
         SDL_Log("Failed to link program: %s\n", compilation_log);
         return GAME_ERROR_SHADER_LINKING_FAILED;
     }
 
+    // Everything drawing needs from the driver, asked once.
+    shader->program = program;
+    shader_reflect(shader);
+
     return GAME_ERROR_NO_ERROR;
 }
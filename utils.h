@@ -7,6 +7,8 @@
 #define GL_GLEXT_PROTOTYPES
 #include <SDL_opengl.h>
 
+#include "shader.h"
+
 enum GameError {
     GAME_ERROR_NO_ERROR = 0,
     GAME_ERROR_ASSETS_DIR_DOES_NOT_EXIST,
@@ -17,7 +19,10 @@ enum GameError {
     GAME_ERROR_FILE_NOT_FOUND,
     GAME_ERROR_VERT_SHADER_COMPILATION_FAILED,
     GAME_ERROR_FRAG_SHADER_COMPILATION_FAILED,
-    GAME_ERROR_SHADER_LINKING_FAILED
+    GAME_ERROR_SHADER_LINKING_FAILED,
+    GAME_ERROR_IMAGE_DECODING_FAILED,
+    GAME_ERROR_ATLAS_PACKING_FAILED,
+    GAME_ERROR_BUFFER_MAPPING_FAILED
 };
 
 /*
@@ -35,10 +40,11 @@ GameError read_whole_file_binary(const char* file_path,
 
 /*
  * Opens shader source from shader assets directory and
- * builds opengl shader program.
+ * builds opengl shader program, then reflects its uniforms
+ * and attributes into shader.
  */
 GameError create_shader_program(std::filesystem::path vert_shader_path,
                                 std::filesystem::path frag_shader_path,
-                                GLuint* program);
+                                Shader* shader);
 
 #endif // !UTILS_H